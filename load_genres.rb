@@ -3,6 +3,7 @@
 require "bundler/inline"
 require "erb"
 require "open-uri"
+require "zlib"
 
 gemfile do
   source "https://rubygems.org"
@@ -10,10 +11,72 @@ gemfile do
   gem "i18n"
 end
 
-I18n.available_locales = [:en]
-
 ID_PATTERN = /:playlist:([A-Za-z0-9]{22})/
 Genre = Struct.new(:name, :id, :label, :color)
+Glyph = Struct.new(:width, :x_advance, :x_delta)
+
+BASE62 = [*"0".."9", *"a".."z", *"A".."Z"].join
+
+# Spotify IDs are base62 encoded 128-bit numbers, see SpotifyId in SpotifyId.h
+def id_value(id)
+  value = id.each_char.reduce(0) { |v, c| v * 62 + BASE62.index(c) }
+  raise "invalid playlist id #{id}" if id.size != 22 || value >= 1 << 128
+
+  value
+end
+
+def id_words(id)
+  value = id_value(id)
+  [96, 64, 32, 0].map { |shift| (value >> shift) & 0xFFFFFFFF }
+end
+
+def id_literal(id)
+  value = id_value(id)
+  format("{0x%016xULL, 0x%016xULL}", value >> 64, value & 0xFFFFFFFFFFFFFFFF)
+end
+
+def rotl32(x, r)
+  ((x << r) | (x >> (32 - r))) & 0xFFFFFFFF
+end
+
+# murmur3 over the ID's 32-bit words, must match SpotifyId::hash()
+def id_hash(id, seed)
+  h = seed
+  id_words(id).each do |w|
+    w = (w * 0xcc9e2d51) & 0xFFFFFFFF
+    w = (rotl32(w, 15) * 0x1b873593) & 0xFFFFFFFF
+    h = (rotl32(h ^ w, 13) * 5 + 0xe6546b64) & 0xFFFFFFFF
+  end
+  h ^= 16
+  h ^= h >> 16
+  h = (h * 0x85ebca6b) & 0xFFFFFFFF
+  h ^= h >> 13
+  h = (h * 0xc2b2ae35) & 0xFFFFFFFF
+  h ^ (h >> 16)
+end
+
+# Build a hash-and-displace perfect hash over playlist IDs. Each key lands in
+# slot (f1 + d * f2) % size, where d is the displacement stored for its bucket.
+def build_playlist_hash(ids)
+  size = (ids.size..).find { |n| (2..Integer.sqrt(n)).none? { |d| (n % d).zero? } }
+  bucket_count = (ids.size / 3.0).ceil
+  keys = ids.each_with_index.map do |id, entity|
+    [entity, id_hash(id, 0) % bucket_count, id_hash(id, 1) % size, id_hash(id, 2) % (size - 1) + 1]
+  end
+  slots = Array.new(size, 0xFFFF)
+  displacements = Array.new(bucket_count, 0)
+  keys.group_by { |key| key[1] }.sort_by { |_, bucket| -bucket.size }.each do |bucket_index, bucket|
+    displacement = (0...size).find do |d|
+      positions = bucket.map { |_, _, f1, f2| (f1 + d * f2) % size }
+      positions.uniq.size == positions.size && positions.all? { |p| slots[p] == 0xFFFF }
+    end
+    raise "unable to place playlist hash bucket #{bucket_index}" unless displacement
+
+    displacements[bucket_index] = displacement
+    bucket.each { |entity, _, f1, f2| slots[(f1 + displacement * f2) % size] = entity }
+  end
+  [displacements, slots]
+end
 
 def build_genre(row)
   name = row.at("td.note:last").text
@@ -33,53 +96,548 @@ def color_565(r, g, b)
   ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3)
 end
 
-sorted_genres = Hash.new { [] }
-%w[background modernity popularity].each do |vector|
-  print "Fetching genre rankings by #{vector}... "
-  doc = Nokogiri::HTML(URI.open("http://everynoise.com/everynoise1d.cgi?vector=#{vector}&scope=all"))
-  sorted_genres[vector] = doc.css("body > table > tr").map(&method(:build_genre))
-  puts "done"
+def fetch_sorted_genres
+  sorted_genres = Hash.new { [] }
+  %w[background modernity popularity].each do |vector|
+    print "Fetching genre rankings by #{vector}... "
+    doc = Nokogiri::HTML(URI.open("http://everynoise.com/everynoise1d.cgi?vector=#{vector}&scope=all"))
+    sorted_genres[vector] = doc.css("body > table > tr").map(&method(:build_genre))
+    puts "done"
+  end
+  sorted_genres
 end
 
-print "Fetching countries... "
-doc = Nokogiri::HTML(URI.open("http://everynoise.com/countries.html"))
-countries = doc.css("td.column .country a")
-  .map { |c| [c.text, c[:href].split(":").last] }
-  .sort_by { |c| I18n.transliterate(c.first) }
-  .to_h
-puts "done"
-
-genres = sorted_genres.values.first
-alphabetical = genres.sort_by(&:name)
-names = alphabetical.map(&:name)
-suffix = genres.sort_by { |genre| genre.name.reverse }
+def fetch_countries
+  I18n.available_locales = [:en]
+  print "Fetching countries... "
+  doc = Nokogiri::HTML(URI.open("http://everynoise.com/countries.html"))
+  countries = doc.css("td.column .country a")
+    .map { |c| [c.text, c[:href].split(":").last] }
+    .to_h
+  puts "done"
+  countries
+end
 
-template = <<-END_TEMPLATE
-#define GENRE_COUNT <%= genres.size %>
+TEMPLATE = <<-END_TEMPLATE
+#define GENRE_CATALOG_VERSION <%= version %>
+#define GENRE_COUNT <%= names.size %>
 #define COUNTRY_COUNT <%= countries.size %>
+#define PLAYLIST_HASH_BUCKETS <%= hash_displacements.size %>
+#define PLAYLIST_HASH_SIZE <%= hash_slots.size %>
 
-const char *genres[GENRE_COUNT] = { <%= names.map(&:inspect).join(", ") %> };
+#define GENRE_NAME_BLOCK_SIZE <%= NAME_BLOCK_SIZE %>
 
-const char *genrePlaylists[GENRE_COUNT] = { <%= alphabetical.map { |g| g.id.inspect }.join(", ") %> };
+// names are front coded in blocks starting at genreNameBlockOffsets[i / GENRE_NAME_BLOCK_SIZE], see front_code in
+// load_genres.rb
+const char genreNames[] = <%= front_coded_pool(genre_names) %>;
 
-const char *countries[COUNTRY_COUNT] = { <%= countries.keys.map(&:inspect).join(", ") %> };
+const uint32_t genreNameBlockOffsets[<%= genre_name_blocks.size %>] = { <%= genre_name_blocks.join(", ") %> };
 
-const char *countryPlaylists[COUNTRY_COUNT] = { <%= countries.values.map(&:inspect).join(", ") %> };
+const SpotifyId genrePlaylists[GENRE_COUNT] = { <%= alphabetical.map { |g| id_literal(g.id) }.join(", ") %> };
 
 const uint16_t genreColors[GENRE_COUNT] = { <%= alphabetical.map { |g| g.color.to_s }.join(", ") %> };
 
-const uint16_t genreIndexes_suffix[GENRE_COUNT] = { <%= suffix.map { |g| names.index(g.name) }.join(", ") %> };
+const char countryNames[] = <%= string_pool(countries.keys) %>;
+
+const uint16_t countryNameOffsets[COUNTRY_COUNT] = { <%= country_name_offsets.join(", ") %> };
 
-<% sorted_genres.each do |vector, sorted| -%>
-const uint16_t genreIndexes_<%= vector %>[GENRE_COUNT] = { <%= sorted.map { |g| names.index(g.name) }.join(", ") %> };
+const SpotifyId countryPlaylists[COUNTRY_COUNT] = { <%= countries.values.map { |id| id_literal(id) }.join(", ") %> };
+
+#define GENRE_PREFIX_CLASSES <%= PREFIX_CLASSES %>
+
+// first index with each one or two character prefix, see prefix_key in load_genres.rb
+const uint16_t genrePrefixStarts[<%= genre_prefix_starts.size %>] = { <%= genre_prefix_starts.join(", ") %> };
+
+// country names sort by their transliteration, so their prefixes can't be read from the names themselves
+const uint16_t countryPrefixKeys[COUNTRY_COUNT] = { <%= country_prefix_keys.join(", ") %> };
+
+const uint16_t countryPrefixStarts[<%= country_prefix_starts.size %>] = { <%= country_prefix_starts.join(", ") %> };
+
+<% unless sorted_genres.empty? -%>
+#define GENRE_RANKINGS
 
-<% if sorted.first.label -%>
-const char *genreLabels_<%= vector %>[GENRE_COUNT] = { <%= sorted.map { |g| g.label.inspect }.join(", ") %> };
 <% end -%>
+<% unless genre_neighbors.empty? -%>
+#define GENRE_NEIGHBOR_COUNT <%= GENRE_NEIGHBORS %>
+
+// the closest genres to each genre by their rankings, nearest first, see build_genre_neighbors in load_genres.rb
+const uint16_t genreNeighbors[GENRE_COUNT * GENRE_NEIGHBOR_COUNT] = { <%= genre_neighbors.join(", ") %> };
+
+<% end -%>
+<% unless genre_popularity_aliases.empty? -%>
+#define GENRE_POPULARITY_ALIASES
+
+// alias table for random genres weighted by popularity, see build_genre_popularity_aliases in load_genres.rb
+const uint32_t genrePopularityAliases[GENRE_COUNT] = { <%= genre_popularity_aliases.join(", ") %> };
+
 <% end -%>
+// line breaks for drawCenteredText, see build_text_layout in load_genres.rb
+<% TEXT_LAYOUT_WIDTHS.each_with_index do |(screen_width, text_width), i| -%>
+#<%= i.zero? ? "if" : "elif" %> TFT_HEIGHT == <%= screen_width %>
+#define GENRE_TEXT_LAYOUT_WIDTH <%= text_width %>
+#define GENRE_TEXT_LAYOUT_SPACE_WIDTH <%= text_layouts[text_width][:space_width] %>
+const uint32_t genreTextLayouts[GENRE_COUNT] = { <%= text_layouts[text_width][:genres].join(", ") %> };
+const uint32_t countryTextLayouts[COUNTRY_COUNT] = { <%= text_layouts[text_width][:countries].join(", ") %> };
+<% end -%>
+#endif
+
+// genreIndexes_* map a sorted menu index to a genre index, genreMenuIndexes_* map it back
+<% orders.each do |order, indexes| -%>
+const uint16_t genreIndexes_<%= order %>[GENRE_COUNT] = { <%= indexes.join(", ") %> };
+
+const uint16_t genreMenuIndexes_<%= order %>[GENRE_COUNT] = { <%= inverse_permutation(indexes).join(", ") %> };
+
+<% if sorted_genres[order]&.first&.label -%>
+const char *genreLabels_<%= order %>[GENRE_COUNT] = { <%= sorted_genres[order].map { |g| g.label.inspect }.join(", ") %> };
+
+<% end -%>
+<% end -%>
+// genre playlists are entities 0 to GENRE_COUNT - 1, followed by country playlists
+const uint16_t playlistHashDisplacements[PLAYLIST_HASH_BUCKETS] = { <%= hash_displacements.join(", ") %> };
+
+const uint16_t playlistHashEntities[PLAYLIST_HASH_SIZE] = { <%= hash_slots.join(", ") %> };
 END_TEMPLATE
-erb = ERB.new(template, trim_mode: "-")
 
-File.open("src/genres.h", "w") do |f|
-  f << erb.result(binding)
+NAME_BLOCK_SIZE = 16
+NAME_CACHE_BLOCK_BYTES = 512 # GENRE_NAME_CACHE_BLOCK_BYTES in GenreCatalog.h
+
+# NUL-terminated strings as adjacent literals, so an escape can't run into the next string
+def string_pool(strings)
+  strings.map { |s| s.inspect.delete_suffix('"') + '\\0"' }.join(" ")
+end
+
+# byte offset of each string in its pool
+def string_offsets(strings)
+  strings.reduce([0]) { |o, s| o << o.last + s.bytesize + 1 }.first(strings.size)
+end
+
+# Sorted names share long prefixes, so each one is stored as a byte with the length of the prefix it shares with the
+# name before it, then the rest of the name and a NUL. Every block of NAME_BLOCK_SIZE names starts over with a full
+# name, so any name can be decoded from the start of its block. Returns the coded names and block offsets.
+def front_code(names)
+  coded = []
+  blocks = []
+  offset = 0
+  names.each_slice(NAME_BLOCK_SIZE) do |block|
+    blocks << offset
+    raise "genre name block too large to cache" if block.sum { |name| name.bytesize + 1 } > NAME_CACHE_BLOCK_BYTES
+
+    previous = "".b
+    block.each do |name|
+      name = name.b
+      shared = 0
+      shared += 1 while shared < 255 && shared < previous.bytesize && name.getbyte(shared) == previous.getbyte(shared)
+      coded << shared.chr + name[shared..]
+      offset += coded.last.bytesize + 1
+      previous = name
+    end
+  end
+  [coded, blocks]
+end
+
+def front_decode(data, offset, count)
+  (0...count).each_slice(NAME_BLOCK_SIZE).flat_map do |block|
+    previous = "".b
+    block.map do
+      length = data.index("\0", offset + 1) - offset - 1
+      previous = previous[0, data.getbyte(offset)] + data[offset + 1, length]
+      offset += length + 2
+      previous.dup.force_encoding("UTF-8")
+    end
+  end
+end
+
+# octal escapes are always three digits and never run into the next character, unlike hex escapes
+def front_coded_pool(coded)
+  coded.map do |name|
+    literal = name.bytes.map do |byte|
+      byte.between?(0x20, 0x7e) && byte != 0x22 && byte != 0x5c ? byte.chr : format("\\%03o", byte)
+    end
+    "\"#{literal.join}\\0\""
+  end.join(" ")
+end
+
+def inverse_permutation(indexes)
+  inverse = Array.new(indexes.size)
+  indexes.each_with_index { |genre_index, menu_index| inverse[genre_index] = menu_index }
+  raise "genre order is not a permutation" if inverse.include?(nil)
+
+  inverse
+end
+
+# genre orders in the catalog partition are tagged with their GenreSortModes value
+ORDER_SORT_MODES = { "suffix" => 1, "background" => 2, "modernity" => 3, "popularity" => 4 }.freeze
+
+CATALOG_MAGIC = 0x54434e4b # "KNCT"
+CATALOG_FORMAT = 6
+CATALOG_HEADER = "L<S<S<L<L<L<S<8L<16".freeze
+CATALOG_HEADER_SIZE = 100
+CATALOG_ORDER = "S<S<L<L<".freeze
+
+PREFIX_CLASSES = 39
+
+# Characters are grouped into classes that keep byte order: anything before "0", each digit, anything between
+# "9" and "a", each lowercase letter, then everything after "z". Must match prefixClass() in GenreCatalog.cpp.
+def prefix_class(byte)
+  if byte.nil? || byte < 0x30
+    0
+  elsif byte <= 0x39
+    byte - 0x30 + 1
+  elsif byte < 0x61
+    11
+  elsif byte <= 0x7a
+    byte - 0x61 + 12
+  else
+    38
+  end
+end
+
+def prefix_key(name)
+  first, second = name.bytes
+  prefix_class(first) * PREFIX_CLASSES + (first ? prefix_class(second) : 0)
+end
+
+# prefix_starts[key] is the first index with a prefix key of at least key, so each first letter or letter pair
+# is a contiguous range of the sorted names
+def build_prefix_starts(keys)
+  raise "names are not sorted by prefix" unless keys.each_cons(2).all? { |a, b| a <= b }
+
+  index = 0
+  (0..PREFIX_CLASSES * PREFIX_CLASSES).map do |key|
+    index += 1 while index < keys.size && keys[index] < key
+    index
+  end
+end
+
+GENRE_NEIGHBORS = 8
+
+# Each genre is a point with one coordinate per ranking, its position in that ranking scaled to 0..1. Points are
+# swept in order of their first coordinate, so the search around each one can stop once that distance alone is
+# further than its farthest neighbor so far.
+def build_genre_neighbors(names, sorted_genres)
+  return [] if sorted_genres.empty?
+
+  ranks = sorted_genres.values.map do |sorted|
+    sorted.each_with_index.map { |genre, rank| [genre.name, rank.to_f / sorted.size] }.to_h
+  end
+  points = names.map { |name| ranks.map { |r| r.fetch(name) } }
+  sweep = points.each_index.sort_by { |i| [points[i][0], i] }
+  sweep_positions = inverse_permutation(sweep)
+
+  points.each_index.flat_map do |i|
+    nearest = []
+    [-1, 1].each do |step|
+      position = sweep_positions[i] + step
+      while position >= 0 && position < sweep.size
+        other = sweep[position]
+        distance = points[i].zip(points[other]).sum { |a, b| (a - b)**2 }
+        break if nearest.size == GENRE_NEIGHBORS && (points[other][0] - points[i][0])**2 >= nearest.last[0]
+
+        if nearest.size < GENRE_NEIGHBORS || distance < nearest.last[0]
+          nearest.insert(nearest.bsearch_index { |n| n[0] > distance } || nearest.size, [distance, other])
+          nearest.pop if nearest.size > GENRE_NEIGHBORS
+        end
+        position += step
+      end
+    end
+    nearest.map(&:last)
+  end
+end
+
+POPULARITY_WEIGHT_EXPONENT = 0.5
+ALIAS_PROBABILITY_ONE = 0x10000
+
+# Walker alias table for picking a genre at random in proportion to its popularity, weighted by 1 / sqrt(rank + 1)
+# since the rankings don't come with scores. Each entry is the chance of keeping its own genre out of 65536 in the low
+# 16 bits and the genre to pick otherwise in the high 16 bits, see GenreCatalog::randomGenre.
+def build_genre_popularity_aliases(names, sorted_genres)
+  return [] unless sorted_genres["popularity"]
+
+  name_indexes = names.each_with_index.to_h
+  weights = Array.new(names.size, 0.0)
+  sorted_genres["popularity"].each_with_index do |genre, rank|
+    weights[name_indexes.fetch(genre.name)] = 1.0 / (rank + 1)**POPULARITY_WEIGHT_EXPONENT
+  end
+  total = weights.sum
+  scaled = weights.map { |weight| weight * names.size / total }
+  aliases = names.each_index.to_a
+  probabilities = Array.new(names.size, ALIAS_PROBABILITY_ONE)
+  small, large = scaled.each_index.partition { |i| scaled[i] < 1 }
+  until small.empty? || large.empty?
+    less = small.pop
+    more = large.last
+    probabilities[less] = (scaled[less] * ALIAS_PROBABILITY_ONE).round
+    aliases[less] = more
+    scaled[more] -= 1 - scaled[less]
+    small << large.pop if scaled[more] < 1
+  end
+  # whatever's left is within rounding of 1 and keeps its own genre, so its probability doesn't matter
+  probabilities.each_index.map do |i|
+    [probabilities[i], ALIAS_PROBABILITY_ONE - 1].min | (aliases[i] << 16)
+  end
+end
+
+# screen width (TFT_HEIGHT) => textWidth in main.h
+TEXT_LAYOUT_WIDTHS = { 240 => 222, 320 => 302 }.freeze
+TEXT_LAYOUT_FONT = "src/GillSans24.vlw"
+CATALOG_TEXT_LAYOUT = "S<S<L<L<".freeze
+
+# glyph metrics from a smooth font, read the same way as TFT_eSPI's loadFont
+def read_font(path)
+  data = File.binread(path)
+  count, _, _, _, ascent, descent = data.unpack("N6")
+  glyphs = count.times.map do |i|
+    unicode, _height, width, x_advance, _y_delta, x_delta = data[24 + i * 28, 24].unpack("N4l>2")
+    [unicode, Glyph.new(width, x_advance, x_delta)]
+  end
+  # the font has no space, so TFT_eSPI guesses its width
+  { glyphs: glyphs.to_h, space_width: (ascent + descent) * 2 / 7 }
+end
+
+# same as TFT_eSPI's decodeUTF8, which doesn't do 4 byte characters
+def decode_utf8(bytes, pos)
+  c = bytes[pos]
+  remaining = bytes.size - pos
+  if c & 0xE0 == 0xC0 && remaining > 1
+    [((c & 0x1F) << 6) | (bytes[pos + 1] & 0x3F), pos + 2]
+  elsif c & 0xF0 == 0xE0 && remaining > 2
+    [((c & 0x0F) << 12) | ((bytes[pos + 1] & 0x3F) << 6) | (bytes[pos + 2] & 0x3F), pos + 3]
+  else
+    [c, pos + 1]
+  end
+end
+
+# Follows drawCenteredText in main.cpp, quirks and all, to find where a name breaks and how wide each line is.
+# Packed as the byte offset of the second line (or the name's length if it fits on one) in bits 0-6, then 9 bits
+# each for the width of the first and second lines. Names that need more than two lines are 0, drawn the slow way.
+def build_text_layout(name, font, max_width)
+  bytes = name.bytes
+  lines = []
+  pos = total_width = preferred_breakpoint = width_at_breakpoint = last_drawn_pos = 0
+  breakpoint_on_space = false
+  while pos < bytes.size
+    last_pos = pos
+    unicode, pos = decode_utf8(bytes, pos)
+    glyph = font[:glyphs][unicode]
+    width = if glyph.nil?
+              font[:space_width] + 1
+            elsif pos == bytes.size - 1
+              glyph.width + glyph.x_delta
+            else
+              glyph.x_advance
+            end
+    total_width += width
+
+    if unicode == 0x20
+      preferred_breakpoint = pos
+      width_at_breakpoint = total_width - width
+      breakpoint_on_space = true
+    elsif unicode == 0x2D || unicode == 0x2F
+      preferred_breakpoint = pos
+      width_at_breakpoint = total_width
+      breakpoint_on_space = false
+    end
+
+    next unless total_width >= max_width - width
+
+    if preferred_breakpoint.zero?
+      preferred_breakpoint = last_pos
+      width_at_breakpoint = total_width
+      breakpoint_on_space = false
+    end
+    lines << [last_drawn_pos, preferred_breakpoint, width_at_breakpoint]
+    last_drawn_pos = preferred_breakpoint
+    total_width -= width_at_breakpoint
+    total_width -= font[:space_width] + 1 if breakpoint_on_space
+    preferred_breakpoint = 0
+  end
+  lines << [last_drawn_pos, bytes.size, total_width] if last_drawn_pos < bytes.size
+
+  return 0 if lines.size > 2 || bytes.size > 0x7F || lines.any? { |start, stop, width| start == stop || width > 0x1FF }
+
+  line_break = lines.size > 1 ? lines[1][0] : bytes.size
+  line_break | (lines[0][2] << 7) | ((lines[1]&.last || 0) << 16)
+end
+
+def build_text_layouts(names, country_names)
+  font = read_font(TEXT_LAYOUT_FONT)
+  TEXT_LAYOUT_WIDTHS.values.to_h do |text_width|
+    [text_width, {
+      space_width: font[:space_width],
+      genres: names.map { |name| build_text_layout(name, font, text_width) },
+      countries: country_names.map { |name| build_text_layout(name, font, text_width) },
+    }]
+  end
+end
+
+def build_catalog(genres, sorted_genres, countries, version)
+  alphabetical = genres.sort_by(&:name)
+  names = alphabetical.map(&:name)
+  countries = countries.sort_by { |name, _| I18n.transliterate(name).downcase }.to_h
+  country_prefix_keys = countries.keys.map { |name| prefix_key(I18n.transliterate(name).downcase) }
+  name_indexes = names.each_with_index.to_h
+  orders = { "suffix" => genres.sort_by { |genre| genre.name.reverse } }.merge(sorted_genres)
+    .transform_values { |sorted| sorted.map { |genre| name_indexes.fetch(genre.name) } }
+  hash_displacements, hash_slots = build_playlist_hash(alphabetical.map(&:id) + countries.values)
+  {
+    version: version,
+    alphabetical: alphabetical,
+    names: names,
+    ids: alphabetical.map(&:id),
+    colors: alphabetical.map(&:color),
+    countries: countries,
+    sorted_genres: sorted_genres,
+    orders: orders,
+    hash_displacements: hash_displacements,
+    hash_slots: hash_slots,
+    genre_prefix_starts: build_prefix_starts(names.map { |name| prefix_key(name) }),
+    country_prefix_keys: country_prefix_keys,
+    country_prefix_starts: build_prefix_starts(country_prefix_keys),
+    genre_neighbors: build_genre_neighbors(names, sorted_genres),
+    genre_popularity_aliases: build_genre_popularity_aliases(names, sorted_genres),
+    text_layouts: build_text_layouts(names, countries.keys),
+  }
+end
+
+def write_genres_header(path, catalog)
+  version, alphabetical, names, countries, sorted_genres, orders, hash_displacements, hash_slots,
+    genre_prefix_starts, country_prefix_keys, country_prefix_starts, genre_neighbors, genre_popularity_aliases,
+    text_layouts =
+    catalog.values_at(:version, :alphabetical, :names, :countries, :sorted_genres, :orders, :hash_displacements,
+                      :hash_slots, :genre_prefix_starts, :country_prefix_keys, :country_prefix_starts,
+                      :genre_neighbors, :genre_popularity_aliases, :text_layouts)
+  genre_names, genre_name_blocks = front_code(names)
+  country_name_offsets = string_offsets(countries.keys)
+  raise "country names too large" if country_name_offsets.max > 0xFFFF
+
+  erb = ERB.new(TEMPLATE, trim_mode: "-")
+  File.open(path, "w") do |f|
+    f << erb.result(binding)
+  end
+end
+
+def id_bytes(id)
+  value = id_value(id)
+  [value >> 64, value & 0xFFFFFFFFFFFFFFFF].pack("Q<Q<")
+end
+
+# Binary catalog for the catalog partition, read in place by GenreCatalog. Every section is
+# aligned to 8 bytes and located by its offset from the start of the header.
+def write_genres_catalog(path, catalog)
+  names, ids, colors, countries, orders, hash_displacements, hash_slots =
+    catalog.values_at(:names, :ids, :colors, :countries, :orders, :hash_displacements, :hash_slots)
+  genre_names, genre_name_blocks = front_code(names)
+  country_name_offsets = string_offsets(countries.keys)
+
+  body = "".b
+  add_section = lambda do |data|
+    body << "\0" * (-(CATALOG_HEADER_SIZE + body.bytesize) % 8)
+    offset = CATALOG_HEADER_SIZE + body.bytesize
+    body << data.b
+    offset
+  end
+  sections = [
+    add_section.call(genre_names.map { |n| n + "\0" }.join),
+    add_section.call(genre_name_blocks.pack("L<*")),
+    add_section.call(ids.map { |id| id_bytes(id) }.join),
+    add_section.call(colors.pack("S<*")),
+    add_section.call(countries.keys.map { |n| n + "\0" }.join),
+    add_section.call(country_name_offsets.pack("S<*")),
+    add_section.call(countries.values.map { |id| id_bytes(id) }.join),
+    add_section.call(hash_displacements.pack("S<*")),
+    add_section.call(hash_slots.pack("S<*")),
+    add_section.call(catalog[:genre_prefix_starts].pack("S<*")),
+    add_section.call(catalog[:country_prefix_keys].pack("S<*")),
+    add_section.call(catalog[:country_prefix_starts].pack("S<*")),
+    catalog[:genre_neighbors].empty? ? 0 : add_section.call(catalog[:genre_neighbors].pack("S<*")),
+    catalog[:genre_popularity_aliases].empty? ? 0 : add_section.call(catalog[:genre_popularity_aliases].pack("L<*")),
+  ]
+  text_layout_entries = catalog[:text_layouts].map do |text_width, layouts|
+    [text_width, layouts[:space_width], add_section.call(layouts[:genres].pack("L<*")),
+     add_section.call(layouts[:countries].pack("L<*"))]
+  end
+  sections << add_section.call(text_layout_entries.map { |entry| entry.pack(CATALOG_TEXT_LAYOUT) }.join)
+  order_entries = orders.map do |order, indexes|
+    [ORDER_SORT_MODES.fetch(order), 0, add_section.call(indexes.pack("S<*")),
+     add_section.call(inverse_permutation(indexes).pack("S<*"))]
+  end
+  sections << add_section.call(order_entries.map { |entry| entry.pack(CATALOG_ORDER) }.join)
+
+  neighbor_count = catalog[:genre_neighbors].empty? ? 0 : GENRE_NEIGHBORS
+  header = [CATALOG_MAGIC, CATALOG_FORMAT, CATALOG_HEADER_SIZE, catalog[:version], CATALOG_HEADER_SIZE + body.bytesize,
+            Zlib.crc32(body), names.size, countries.size, hash_displacements.size, hash_slots.size, NAME_BLOCK_SIZE,
+            order_entries.size, neighbor_count, text_layout_entries.size, *sections].pack(CATALOG_HEADER)
+  File.binwrite(path, header + body)
+end
+
+# Parse a binary catalog back into the fields written by write_genres_catalog
+def read_genres_catalog(path)
+  data = File.binread(path)
+  magic, format, header_size, version, size, crc, genre_count, country_count, hash_buckets, hash_size, block_size,
+    order_count, neighbor_count, text_layout_count, *sections = data.unpack(CATALOG_HEADER)
+  raise "not a genre catalog" unless magic == CATALOG_MAGIC && format == CATALOG_FORMAT
+  raise "catalog checksum mismatch" unless size == data.bytesize && crc == Zlib.crc32(data[header_size..])
+
+  strings = ->(offset, count) { data[offset..].split("\0", count + 1).first(count).map { |s| s.force_encoding("UTF-8") } }
+  words = ->(offset, count, format) { data[offset, count * (format == "L<" ? 4 : 2)].unpack("#{format}*") }
+  ids = lambda do |offset, count|
+    count.times.map do |i|
+      high, low = data[offset + i * 16, 16].unpack("Q<Q<")
+      value = (high << 64) | low
+      22.times.map { c = BASE62[value % 62]; value /= 62; c }.reverse.join
+    end
+  end
+  genre_names, blocks, genre_ids, colors, country_names, _, country_ids, displacements, slots,
+    genre_prefix_starts, country_prefix_keys, country_prefix_starts, genre_neighbors, popularity_aliases, text_layouts,
+    orders = sections
+  prefix_starts_size = PREFIX_CLASSES * PREFIX_CLASSES + 1
+  raise "unexpected genre name block size" unless block_size == NAME_BLOCK_SIZE
+
+  names = front_decode(data, genre_names, genre_count)
+  computed_blocks = front_code(names).last
+  raise "catalog name blocks mismatch" unless words.call(blocks, computed_blocks.size, "L<") == computed_blocks
+
+  {
+    version: version,
+    names: names,
+    ids: ids.call(genre_ids, genre_count),
+    colors: words.call(colors, genre_count, "S<"),
+    countries: strings.call(country_names, country_count).zip(ids.call(country_ids, country_count)).to_h,
+    orders: order_count.times.map do |i|
+      sort_mode, _, indexes, = data[orders + i * 12, 12].unpack(CATALOG_ORDER)
+      [ORDER_SORT_MODES.key(sort_mode), words.call(indexes, genre_count, "S<")]
+    end.to_h,
+    hash_displacements: words.call(displacements, hash_buckets, "S<"),
+    hash_slots: words.call(slots, hash_size, "S<"),
+    genre_prefix_starts: words.call(genre_prefix_starts, prefix_starts_size, "S<"),
+    country_prefix_keys: words.call(country_prefix_keys, country_count, "S<"),
+    country_prefix_starts: words.call(country_prefix_starts, prefix_starts_size, "S<"),
+    genre_neighbors: neighbor_count.zero? ? [] : words.call(genre_neighbors, genre_count * neighbor_count, "S<"),
+    genre_popularity_aliases: popularity_aliases.zero? ? [] : words.call(popularity_aliases, genre_count, "L<"),
+    text_layouts: text_layout_count.times.to_h do |i|
+      text_width, space_width, genre_layouts, country_layouts =
+        data[text_layouts + i * 12, 12].unpack(CATALOG_TEXT_LAYOUT)
+      [text_width, {
+        space_width: space_width,
+        genres: words.call(genre_layouts, genre_count, "L<"),
+        countries: words.call(country_layouts, country_count, "L<"),
+      }]
+    end,
+  }
+end
+
+def verify_genres_catalog(path, catalog)
+  read = read_genres_catalog(path)
+  read.each do |key, value|
+    raise "catalog #{key} did not round-trip" unless value == catalog[key]
+  end
+end
+
+if __FILE__ == $PROGRAM_NAME
+  sorted_genres = fetch_sorted_genres
+  countries = fetch_countries
+  catalog = build_catalog(sorted_genres.values.first, sorted_genres, countries, Time.now.utc.strftime("%Y%m%d").to_i)
+  write_genres_header("src/genres.h", catalog)
+  write_genres_catalog("catalog.bin", catalog)
+  verify_genres_catalog("catalog.bin", catalog)
 end
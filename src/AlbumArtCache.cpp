@@ -0,0 +1,233 @@
+#include "AlbumArtCache.h"
+
+#include <SPIFFS.h>
+
+#include <vector>
+
+// holds the cache's lock for the scope it's declared in
+class AlbumArtCacheLock {
+ public:
+  AlbumArtCacheLock(SemaphoreHandle_t lock) : _lock(lock) {
+    if (_lock) xSemaphoreTake(_lock, portMAX_DELAY);
+  }
+  ~AlbumArtCacheLock() {
+    if (_lock) xSemaphoreGive(_lock);
+  }
+
+ protected:
+  SemaphoreHandle_t _lock;
+};
+
+bool AlbumArtCache::setup() {
+  _lock = xSemaphoreCreateMutex();
+#ifdef BOARD_HAS_PSRAM
+  _tiles = (uint16_t *)ps_malloc(ALBUM_ART_CACHE_TILES * ALBUM_ART_BYTES);
+#else
+  _tiles = (uint16_t *)malloc(ALBUM_ART_CACHE_TILES * ALBUM_ART_BYTES);
+#endif
+  if (!_tiles) {
+    log_e("no memory for %u album images", ALBUM_ART_CACHE_TILES);
+    return false;
+  }
+
+  // pick up images from before the last sleep, anything else that looks like one is left over and goes
+  File root = SPIFFS.open("/");
+  std::vector<String> stale;
+  uint8_t files = 0;
+  for (File file = root.openNextFile(); file; file = root.openNextFile()) {
+    String name = file.name();
+    if (!name.startsWith("/")) name = "/" + name;
+    if (!name.startsWith(ALBUM_ART_CACHE_PATH_PREFIX)) continue;
+    const uint32_t key = strtoul(name.c_str() + strlen(ALBUM_ART_CACHE_PATH_PREFIX), nullptr, 16);
+    const bool valid = file.size() == ALBUM_ART_BYTES && key != 0 && files < ALBUM_ART_CACHE_FILES;
+    file.close();
+    if (valid) {
+      _files[files].key = key;
+      _files[files].lastUsed = ++_clock;
+      files++;
+    } else {
+      stale.push_back(name);
+    }
+  }
+  root.close();
+  for (auto &name : stale) SPIFFS.remove(name);
+  return true;
+}
+
+uint32_t AlbumArtCache::key(const char *url) {
+  // FNV-1a
+  uint32_t hash = 2166136261u;
+  for (const char *c = url; *c != '\0'; c++) hash = (hash ^ (uint8_t)*c) * 16777619u;
+  return hash;
+}
+
+bool AlbumArtCache::cached(uint32_t key) {
+  AlbumArtCacheLock lock(_lock);
+  if (!_tiles) return false;
+  return findEntry(_entries, ALBUM_ART_CACHE_TILES, key) != nullptr;
+}
+
+bool AlbumArtCache::load(uint32_t key) {
+  AlbumArtCacheEntry_t *file;
+  {
+    AlbumArtCacheLock lock(_lock);
+    file = findEntry(_files, ALBUM_ART_CACHE_FILES, key);
+  }
+  if (!file) return false;
+  uint16_t *pixels = beginStore(key);
+  if (!pixels) return false;
+
+  const bool read = readFile(key, pixels);
+  if (read) {
+    AlbumArtCacheLock lock(_lock);
+    _fileHits++;
+  } else {
+    removeFile(file);
+  }
+  endStore(key, read);
+  return read;
+}
+
+bool AlbumArtCache::draw(uint32_t key, DisplayBackend &display, int32_t x, int32_t y) {
+  AlbumArtCacheLock lock(_lock);
+  if (!_tiles) return false;
+  AlbumArtCacheEntry_t *entry = findEntry(_entries, ALBUM_ART_CACHE_TILES, key);
+  if (!entry) {
+    _misses++;
+    return false;
+  }
+  _hits++;
+  entry->lastUsed = ++_clock;
+  display.pushRegion(x, y, ALBUM_ART_SIZE, ALBUM_ART_SIZE, tile(entry), ALBUM_ART_SIZE);
+  return true;
+}
+
+uint16_t *AlbumArtCache::beginStore(uint32_t key) {
+  AlbumArtCacheLock lock(_lock);
+  if (!_tiles || _storing) return nullptr;
+  AlbumArtCacheEntry_t *entry = findEntry(_entries, ALBUM_ART_CACHE_TILES, key);
+  if (!entry) entry = leastRecentlyUsed(_entries, ALBUM_ART_CACHE_TILES);
+  // not found until it's decoded
+  entry->key = key;
+  entry->lastUsed = 0;
+  _storing = entry;
+  return tile(entry);
+}
+
+void AlbumArtCache::endStore(uint32_t key, bool decoded) {
+  AlbumArtCacheEntry_t *entry = nullptr;
+  {
+    AlbumArtCacheLock lock(_lock);
+    if (_storing && _storing->key == key && decoded) {
+      entry = _storing;
+      entry->lastUsed = ++_clock;
+      // only a new album is written, one read back or already in SPIFFS just counts as used
+      AlbumArtCacheEntry_t *file = findEntry(_files, ALBUM_ART_CACHE_FILES, key);
+      if (file) {
+        file->lastUsed = entry->lastUsed;
+        entry = nullptr;
+      }
+    }
+    if (!entry) {
+      _storing = nullptr;
+      return;
+    }
+  }
+
+  // the loop can draw the tile while it's written, and beginStore won't hand it out again until _storing is cleared
+  writeFile(key, tile(entry));
+  AlbumArtCacheLock lock(_lock);
+  _storing = nullptr;
+}
+
+uint16_t AlbumArtCache::tilesUsed() {
+  AlbumArtCacheLock lock(_lock);
+  uint16_t used = 0;
+  for (auto &entry : _entries) {
+    if (entry.lastUsed != 0) used++;
+  }
+  return used;
+}
+
+uint16_t AlbumArtCache::filesUsed() {
+  AlbumArtCacheLock lock(_lock);
+  uint16_t used = 0;
+  for (auto &file : _files) {
+    if (file.lastUsed != 0) used++;
+  }
+  return used;
+}
+
+AlbumArtCacheEntry_t *AlbumArtCache::findEntry(AlbumArtCacheEntry_t *entries, uint8_t count, uint32_t key) {
+  for (uint8_t i = 0; i < count; i++) {
+    if (entries[i].lastUsed != 0 && entries[i].key == key) return &entries[i];
+  }
+  return nullptr;
+}
+
+AlbumArtCacheEntry_t *AlbumArtCache::leastRecentlyUsed(AlbumArtCacheEntry_t *entries, uint8_t count) {
+  AlbumArtCacheEntry_t *oldest = &entries[0];
+  for (uint8_t i = 1; i < count; i++) {
+    if (entries[i].lastUsed < oldest->lastUsed) oldest = &entries[i];
+  }
+  return oldest;
+}
+
+String AlbumArtCache::path(uint32_t key) {
+  char path[16];
+  snprintf(path, sizeof(path), ALBUM_ART_CACHE_PATH_PREFIX "%08x", key);
+  return path;
+}
+
+bool AlbumArtCache::readFile(uint32_t key, uint16_t *pixels) {
+  File file = SPIFFS.open(path(key), "r");
+  if (!file) return false;
+  const size_t read = file.read((uint8_t *)pixels, ALBUM_ART_BYTES);
+  file.close();
+  return read == ALBUM_ART_BYTES;
+}
+
+// files are only changed by the background task, so it can look at them without the lock, but changes are made while
+// holding it for filesUsed
+void AlbumArtCache::writeFile(uint32_t key, const uint16_t *pixels) {
+  AlbumArtCacheEntry_t *file = leastRecentlyUsed(_files, ALBUM_ART_CACHE_FILES);
+  removeFile(file);
+  // data.json has to be able to grow, so older images go first if the partition is getting full
+  while (SPIFFS.totalBytes() - SPIFFS.usedBytes() < ALBUM_ART_BYTES + ALBUM_ART_CACHE_SPIFFS_RESERVE) {
+    AlbumArtCacheEntry_t *oldest = nullptr;
+    for (auto &candidate : _files) {
+      if (candidate.lastUsed != 0 && (!oldest || candidate.lastUsed < oldest->lastUsed)) oldest = &candidate;
+    }
+    if (!oldest) {
+      log_i("no room in SPIFFS for album image");
+      return;
+    }
+    removeFile(oldest);
+  }
+
+  File out = SPIFFS.open(path(key), "w");
+  if (!out) return;
+  const size_t written = out.write((const uint8_t *)pixels, ALBUM_ART_BYTES);
+  out.close();
+  if (written != ALBUM_ART_BYTES) {
+    log_e("unable to write album image, %u of %u bytes", written, ALBUM_ART_BYTES);
+    SPIFFS.remove(path(key));
+    return;
+  }
+  AlbumArtCacheLock lock(_lock);
+  file->key = key;
+  file->lastUsed = ++_clock;
+}
+
+void AlbumArtCache::removeFile(AlbumArtCacheEntry_t *file) {
+  if (file->lastUsed == 0) return;
+  const uint32_t key = file->key;
+  {
+    AlbumArtCacheLock lock(_lock);
+    file->key = 0;
+    file->lastUsed = 0;
+  }
+  SPIFFS.remove(path(key));
+}
+
+AlbumArtCache albumArtCache;
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "DisplayBackend.h"
+
+#define ALBUM_ART_SIZE 64
+#define ALBUM_ART_BYTES (ALBUM_ART_SIZE * ALBUM_ART_SIZE * sizeof(uint16_t))
+
+// plenty of albums with PSRAM, otherwise just the one showing in memory
+#ifdef BOARD_HAS_PSRAM
+#define ALBUM_ART_CACHE_TILES 32
+#else
+#define ALBUM_ART_CACHE_TILES 1
+#endif
+// the last few new albums are also written to SPIFFS, which deep sleep doesn't clear, and which shares its 64KB
+// partition with data.json, so it has to keep ALBUM_ART_CACHE_SPIFFS_RESERVE free for that to grow into
+#define ALBUM_ART_CACHE_FILES 2
+#define ALBUM_ART_CACHE_SPIFFS_RESERVE (8 * 1024)
+#define ALBUM_ART_CACHE_PATH_PREFIX "/art"
+
+typedef struct {
+  uint32_t key = 0;
+  uint32_t lastUsed = 0;
+} AlbumArtCacheEntry_t;
+
+// Album images already decoded, kept as 64x64 RGB565 tiles in the byte order the JPEG decoder writes them, so showing
+// an album again skips both downloading and decoding its image. Tiles are found by a hash of the image URL and the
+// least recently used one is replaced. Images are stored by the background task while the main loop draws them, so
+// every call takes a lock, and tiles are only read while it's held. Files are only read and written by the background
+// task, outside the lock, so drawing never waits on SPIFFS.
+class AlbumArtCache {
+ public:
+  // after SPIFFS is mounted
+  bool setup();
+
+  static uint32_t key(const char *url);
+
+  // whether an image is in memory, without counting as a hit or miss
+  bool cached(uint32_t key);
+  // read an image back from SPIFFS into a tile, skipping the download, false if it isn't there
+  bool load(uint32_t key);
+  // push the decoded image to the display, which copies it before the lock is let go, false if it isn't cached
+  bool draw(uint32_t key, DisplayBackend &display, int32_t x, int32_t y);
+  // a tile to decode an image into, replacing the least recently used one, and left alone until endStore
+  uint16_t *beginStore(uint32_t key);
+  // once the image is decoded, or failed to and the tile should be dropped, and written to SPIFFS if it's new
+  void endStore(uint32_t key, bool decoded);
+
+  uint32_t hits() { return _hits; }
+  uint32_t misses() { return _misses; }
+  uint32_t fileHits() { return _fileHits; }
+  uint16_t tilesUsed();
+  uint16_t filesUsed();
+
+ protected:
+  static AlbumArtCacheEntry_t *findEntry(AlbumArtCacheEntry_t *entries, uint8_t count, uint32_t key);
+  static AlbumArtCacheEntry_t *leastRecentlyUsed(AlbumArtCacheEntry_t *entries, uint8_t count);
+  uint16_t *tile(AlbumArtCacheEntry_t *entry) { return _tiles + (entry - _entries) * ALBUM_ART_SIZE * ALBUM_ART_SIZE; }
+  static String path(uint32_t key);
+  bool readFile(uint32_t key, uint16_t *pixels);
+  void writeFile(uint32_t key, const uint16_t *pixels);
+  void removeFile(AlbumArtCacheEntry_t *file);
+
+  SemaphoreHandle_t _lock = nullptr;
+  uint16_t *_tiles = nullptr;
+  // the tile being decoded into
+  AlbumArtCacheEntry_t *_storing = nullptr;
+  AlbumArtCacheEntry_t _entries[ALBUM_ART_CACHE_TILES];
+  AlbumArtCacheEntry_t _files[ALBUM_ART_CACHE_FILES];
+  uint32_t _clock = 0;
+  uint32_t _hits = 0;
+  uint32_t _misses = 0;
+  uint32_t _fileHits = 0;
+};
+
+extern AlbumArtCache albumArtCache;
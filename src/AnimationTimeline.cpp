@@ -0,0 +1,25 @@
+#include "AnimationTimeline.h"
+
+void AnimationTimeline::start(Animations animation, unsigned long now, unsigned long delayMillis) {
+  _animations[animation].running = true;
+  _animations[animation].startMillis = now;
+  _animations[animation].keyframeMillis = now + delayMillis;
+}
+
+bool AnimationTimeline::keyframeDue(Animations animation, unsigned long now) {
+  const Animation_t &a = _animations[animation];
+  return a.running && (long)(now - a.keyframeMillis) >= 0;
+}
+
+unsigned long AnimationTimeline::millisUntilKeyframe(unsigned long now) {
+  unsigned long until = UINT32_MAX;
+  for (const auto &a : _animations) {
+    if (!a.running) continue;
+    const long remaining = a.keyframeMillis - now;
+    if (remaining <= 0) return 0;
+    if ((unsigned long)remaining < until) until = remaining;
+  }
+  return until;
+}
+
+AnimationTimeline animationTimeline;
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdint.h>
+
+// things on screen, and the backlight, that change over time rather than in response to input
+enum Animations {
+  BacklightFadeAnimation = 0,
+  ProgressSweepAnimation = 1,
+  ClickEffectAnimation = 2,
+  RandomizingAnimation = 3,
+  MarqueeAnimation = 4
+};
+const int animationsCount = 5;
+
+typedef struct {
+  bool running = false;
+  unsigned long startMillis = 0;
+  unsigned long keyframeMillis = 0;
+} Animation_t;
+
+// When each running animation next needs something done, so the loop can act on keyframes as they come due and sleep
+// until the next one instead of checking every animation on every pass.
+class AnimationTimeline {
+ public:
+  // the first keyframe comes after delayMillis
+  void start(Animations animation, unsigned long now, unsigned long delayMillis = 0);
+  void stop(Animations animation) { _animations[animation].running = false; }
+  bool running(Animations animation) { return _animations[animation].running; }
+  unsigned long elapsedMillis(Animations animation, unsigned long now) {
+    return now - _animations[animation].startMillis;
+  }
+
+  // stays due until the next keyframe is set or the animation stops
+  bool keyframeDue(Animations animation, unsigned long now);
+  void nextKeyframe(Animations animation, unsigned long keyframeMillis) {
+    _animations[animation].keyframeMillis = keyframeMillis;
+  }
+
+  // how long until any running animation has a keyframe due, or UINT32_MAX if none are running
+  unsigned long millisUntilKeyframe(unsigned long now);
+
+ protected:
+  Animation_t _animations[animationsCount];
+};
+
+extern AnimationTimeline animationTimeline;
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+// Where composed regions of the display end up. Pixels are RGB565 in the byte swapped order sprites and the JPEG
+// decoder hold them, stride is the distance between rows in pixels.
+class DisplayBackend {
+ public:
+  virtual ~DisplayBackend() {}
+
+  virtual void pushRegion(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *pixels, int32_t stride) = 0;
+  // color is RGB565 as it's drawn, not byte swapped
+  virtual void fillRegion(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) = 0;
+  // wait for everything pushed so far to reach the display
+  virtual void waitIdle() {}
+
+  // time spent pushing regions to the display, and time composing spent waiting on it
+  virtual uint32_t flushMicros() { return 0; }
+  virtual uint32_t waitMicros() { return 0; }
+  // share of the time spent pushing that composing carried on alongside, from 0 to 1
+  float overlapRatio() {
+    const uint32_t flush = flushMicros();
+    const uint32_t wait = waitMicros();
+    return flush == 0 || wait >= flush ? 0.0f : (float)(flush - wait) / flush;
+  }
+};
+
+// A display held in memory, so rendering can be driven and checked without hardware
+class FramebufferDisplay : public DisplayBackend {
+ public:
+  FramebufferDisplay(uint16_t *pixels, int32_t width, int32_t height)
+      : _pixels(pixels), _width(width), _height(height) {}
+
+  void pushRegion(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *pixels, int32_t stride) override {
+    const int32_t start = x < 0 ? -x : 0;
+    const int32_t end = x + w > _width ? _width - x : w;
+    for (int32_t row = 0; row < h && end > start; row++) {
+      if (y + row < 0 || y + row >= _height) continue;
+      memcpy(_pixels + (y + row) * _width + x + start, pixels + row * stride + start, (end - start) * sizeof(uint16_t));
+    }
+    _regions++;
+  }
+
+  void fillRegion(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) override {
+    const uint16_t swapped = (uint16_t)((color >> 8) | (color << 8));
+    for (int32_t row = y < 0 ? 0 : y; row < y + h && row < _height; row++) {
+      for (int32_t column = x < 0 ? 0 : x; column < x + w && column < _width; column++) {
+        _pixels[row * _width + column] = swapped;
+      }
+    }
+    _regions++;
+  }
+
+  const uint16_t *pixels() { return _pixels; }
+  uint32_t regions() { return _regions; }
+
+ protected:
+  uint16_t *_pixels;
+  int32_t _width;
+  int32_t _height;
+  uint32_t _regions = 0;
+};
@@ -0,0 +1,29 @@
+#include "FrameScheduler.h"
+
+#include <Arduino.h>
+
+void FrameScheduler::setMaxFps(int fps) {
+  _maxFps = constrain(fps, 1, FRAME_SCHEDULER_MAX_FPS);
+  _frameIntervalMillis = 1000 / _maxFps;
+}
+
+void FrameScheduler::beginFrame() {
+  _lastFrameMillis = millis();
+  _frameStartMicros = micros();
+}
+
+void FrameScheduler::endFrame() {
+  _lastFrameMicros = micros() - _frameStartMicros;
+  _maxFrameMicros = max(_maxFrameMicros, _lastFrameMicros);
+  _totalFrameMicros += _lastFrameMicros;
+  _framesRendered++;
+}
+
+bool FrameScheduler::widgetDue(FrameWidgets widget, unsigned long now) {
+  const unsigned long deadline = _widgetDeadlines[widget];
+  if (deadline == 0 || now < deadline) return false;
+  _widgetDeadlines[widget] = 0;
+  return true;
+}
+
+FrameScheduler frameScheduler;
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdint.h>
+
+#define FRAME_SCHEDULER_DEFAULT_FPS 30
+#define FRAME_SCHEDULER_MAX_FPS 60
+
+// parts of the display that expire on their own schedule rather than when something invalidates it
+enum FrameWidgets {
+  StatusMessageWidget = 0
+};
+const int frameWidgetsCount = 1;
+
+// Decides when the display gets drawn. Everything that invalidates it between frames is coalesced into one frame,
+// drawn no sooner than a frame interval after the last, so spinning the knob only draws the menu index it's landed on
+// by then. Widgets get deadlines instead of being checked or drawn on every loop.
+class FrameScheduler {
+ public:
+  // clamped to 1 to FRAME_SCHEDULER_MAX_FPS before it's stored, so out of range settings can't wrap around
+  void setMaxFps(int fps);
+  uint8_t maxFps() { return _maxFps; }
+  unsigned long frameIntervalMillis() { return _frameIntervalMillis; }
+
+  // an invalidation that comes while another is still waiting for its frame is counted as a skipped frame
+  void invalidated(bool alreadyWaiting) {
+    if (alreadyWaiting) _framesSkipped++;
+  }
+  bool frameDue(unsigned long now) { return now - _lastFrameMillis >= _frameIntervalMillis; }
+  void beginFrame();
+  void endFrame();
+
+  // a deadline of 0 clears it
+  void scheduleWidget(FrameWidgets widget, unsigned long deadline) { _widgetDeadlines[widget] = deadline; }
+  // true once when the widget's deadline has passed
+  bool widgetDue(FrameWidgets widget, unsigned long now);
+
+  uint32_t framesRendered() { return _framesRendered; }
+  uint32_t framesSkipped() { return _framesSkipped; }
+  uint32_t lastFrameMicros() { return _lastFrameMicros; }
+  uint32_t maxFrameMicros() { return _maxFrameMicros; }
+  uint32_t averageFrameMicros() { return _framesRendered > 0 ? _totalFrameMicros / _framesRendered : 0; }
+
+ protected:
+  uint8_t _maxFps = FRAME_SCHEDULER_DEFAULT_FPS;
+  unsigned long _frameIntervalMillis = 1000 / FRAME_SCHEDULER_DEFAULT_FPS;
+  unsigned long _lastFrameMillis = 0;
+  unsigned long _frameStartMicros = 0;
+  unsigned long _widgetDeadlines[frameWidgetsCount] = {};
+  uint32_t _framesRendered = 0;
+  uint32_t _framesSkipped = 0;
+  uint32_t _lastFrameMicros = 0;
+  uint32_t _maxFrameMicros = 0;
+  uint64_t _totalFrameMicros = 0;
+};
+
+extern FrameScheduler frameScheduler;
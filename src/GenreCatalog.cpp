@@ -0,0 +1,512 @@
+#include "GenreCatalog.h"
+
+#include <Arduino.h>
+#include <esp_rom_crc.h>
+
+#include "genres.h"
+
+static_assert(GENRE_NAME_BLOCK_SIZE <= GENRE_NAME_CACHE_BLOCK_NAMES, "genre name blocks don't fit in the cache");
+
+class GenreNameCacheLock {
+ public:
+  GenreNameCacheLock(SemaphoreHandle_t lock) : _lock(lock) {
+    if (_lock) xSemaphoreTake(_lock, portMAX_DELAY);
+  }
+  ~GenreNameCacheLock() {
+    if (_lock) xSemaphoreGive(_lock);
+  }
+
+ protected:
+  SemaphoreHandle_t _lock;
+};
+
+void GenreCatalog::setup() {
+  if (!_genreNameCacheLock) _genreNameCacheLock = xSemaphoreCreateMutex();
+  useBuiltIn();
+
+  _partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                        (esp_partition_subtype_t)GENRE_CATALOG_PARTITION_SUBTYPE,
+                                        GENRE_CATALOG_PARTITION_LABEL);
+  if (!_partition) {
+    log_i("no catalog partition, using built-in catalog %u", GENRE_CATALOG_VERSION);
+    return;
+  }
+
+  const void *data = nullptr;
+  if (esp_partition_mmap(_partition, 0, _partition->size, SPI_FLASH_MMAP_DATA, &data, &_mappedHandle) != ESP_OK) {
+    log_e("unable to map catalog partition");
+    return;
+  }
+  _mapped = true;
+
+  auto header = (const GenreCatalogHeader_t *)data;
+  if (!isValid((const uint8_t *)data, _partition->size)) {
+    log_i("no valid catalog in partition, using built-in catalog %u", GENRE_CATALOG_VERSION);
+  } else if (header->version < GENRE_CATALOG_VERSION) {
+    log_i("catalog %u in partition is older than built-in catalog %u", header->version, GENRE_CATALOG_VERSION);
+  } else {
+    load((const uint8_t *)data);
+    log_i("using catalog %u from partition", _version);
+    return;
+  }
+  spi_flash_munmap(_mappedHandle);
+  _mapped = false;
+}
+
+void GenreCatalog::useBuiltIn() {
+  // a mapped partition stays mapped, something might still be reading from it
+  _usingPartition = false;
+  _version = GENRE_CATALOG_VERSION;
+  _genreCount = GENRE_COUNT;
+  _countryCount = COUNTRY_COUNT;
+  _playlistHashBuckets = PLAYLIST_HASH_BUCKETS;
+  _playlistHashSize = PLAYLIST_HASH_SIZE;
+  _genreNameBlockSize = GENRE_NAME_BLOCK_SIZE;
+  clearNameCache();
+  _genreNames = genreNames;
+  _genreNameBlockOffsets = genreNameBlockOffsets;
+  _genrePlaylists = genrePlaylists;
+  _genreColors = genreColors;
+  _countryNames = countryNames;
+  _countryNameOffsets = countryNameOffsets;
+  _countryPlaylists = countryPlaylists;
+  _playlistHashDisplacements = playlistHashDisplacements;
+  _playlistHashEntities = playlistHashEntities;
+  _genrePrefixStarts = genrePrefixStarts;
+  _countryPrefixKeys = countryPrefixKeys;
+  _countryPrefixStarts = countryPrefixStarts;
+#ifdef GENRE_NEIGHBOR_COUNT
+  _genreNeighborCount = GENRE_NEIGHBOR_COUNT;
+  _genreNeighbors = ::genreNeighbors;
+#else
+  _genreNeighborCount = 0;
+  _genreNeighbors = nullptr;
+#endif
+#ifdef GENRE_POPULARITY_ALIASES
+  _genrePopularityAliases = genrePopularityAliases;
+#else
+  _genrePopularityAliases = nullptr;
+#endif
+  _data = nullptr;
+  _textLayoutCount = 0;
+  _textLayouts = nullptr;
+  _genreTextLayouts = nullptr;
+  _countryTextLayouts = nullptr;
+
+  for (auto i = 0; i < genreSortModesCount; i++) {
+    _genreIndexes[i] = nullptr;
+    _genreMenuIndexes[i] = nullptr;
+  }
+  _genreIndexes[AlphabeticSuffixSort] = genreIndexes_suffix;
+  _genreMenuIndexes[AlphabeticSuffixSort] = genreMenuIndexes_suffix;
+#ifdef GENRE_RANKINGS
+  _genreIndexes[BackgroundSort] = genreIndexes_background;
+  _genreMenuIndexes[BackgroundSort] = genreMenuIndexes_background;
+  _genreIndexes[ModernitySort] = genreIndexes_modernity;
+  _genreMenuIndexes[ModernitySort] = genreMenuIndexes_modernity;
+  _genreIndexes[PopularitySort] = genreIndexes_popularity;
+  _genreMenuIndexes[PopularitySort] = genreMenuIndexes_popularity;
+#endif
+}
+
+const uint16_t *GenreCatalog::genreIndexes(GenreSortModes sort) {
+  return sort >= 0 && sort < genreSortModesCount ? _genreIndexes[sort] : nullptr;
+}
+
+const uint16_t *GenreCatalog::genreMenuIndexes(GenreSortModes sort) {
+  return sort >= 0 && sort < genreSortModesCount ? _genreMenuIndexes[sort] : nullptr;
+}
+
+int GenreCatalog::findPlaylist(const SpotifyId &id) {
+  const uint32_t f1 = id.hash(1) % _playlistHashSize;
+  const uint32_t f2 = id.hash(2) % (_playlistHashSize - 1) + 1;
+  const uint32_t displacement = _playlistHashDisplacements[id.hash(0) % _playlistHashBuckets];
+  const uint16_t entity = _playlistHashEntities[(f1 + displacement * f2) % _playlistHashSize];
+  if (entity < _genreCount) {
+    return _genrePlaylists[entity] == id ? entity : -1;
+  } else if (entity < _genreCount + _countryCount) {
+    return _countryPlaylists[entity - _genreCount] == id ? entity : -1;
+  }
+  return -1;
+}
+
+// entries are the chance of keeping the genre out of 65536, then the genre to pick instead, see
+// build_genre_popularity_aliases in load_genres.rb
+uint16_t GenreCatalog::randomGenre(bool byPopularity) {
+  const uint16_t index = random(_genreCount);
+  if (!byPopularity || !_genrePopularityAliases) return index;
+  const uint32_t entry = _genrePopularityAliases[index];
+  return random(0x10000) < (entry & 0xffff) ? index : entry >> 16;
+}
+
+bool GenreCatalog::useTextLayouts(uint16_t textWidth, uint16_t spaceWidth) {
+  _genreTextLayouts = nullptr;
+  _countryTextLayouts = nullptr;
+  if (!_usingPartition) {
+#ifdef GENRE_TEXT_LAYOUT_WIDTH
+    if (textWidth == GENRE_TEXT_LAYOUT_WIDTH && spaceWidth == GENRE_TEXT_LAYOUT_SPACE_WIDTH) {
+      _genreTextLayouts = genreTextLayouts;
+      _countryTextLayouts = countryTextLayouts;
+    }
+#endif
+  } else {
+    for (auto i = 0; i < _textLayoutCount; i++) {
+      if (_textLayouts[i].textWidth == textWidth && _textLayouts[i].spaceWidth == spaceWidth) {
+        _genreTextLayouts = (const uint32_t *)(_data + _textLayouts[i].genreLayouts);
+        _countryTextLayouts = (const uint32_t *)(_data + _textLayouts[i].countryLayouts);
+        break;
+      }
+    }
+  }
+  if (!_genreTextLayouts) log_i("no text layouts for width %d, measuring names as they're drawn", textWidth);
+  return _genreTextLayouts != nullptr;
+}
+
+const char *GenreCatalog::genreName(uint16_t index, char *name, size_t size) {
+  GenreNameCacheLock lock(_genreNameCacheLock);
+  const int32_t block = index / _genreNameBlockSize;
+  GenreNameCacheBlock_t *cached = nullptr;
+  for (auto &entry : _genreNameCache) {
+    if (entry.block == block) {
+      cached = &entry;
+      break;
+    }
+  }
+
+  if (!cached) {
+    cached = &_genreNameCache[0];
+    for (auto &entry : _genreNameCache) {
+      if (entry.lastUsed < cached->lastUsed) cached = &entry;
+    }
+    const uint16_t count = min((int)_genreNameBlockSize, _genreCount - block * _genreNameBlockSize);
+    // built-in and partition catalogs are validated, so this only fails if the cache is too small for a block
+    if (!decodeNameBlock(_genreNames + _genreNameBlockOffsets[block], nullptr, count, cached)) {
+      cached->block = -1;
+      if (size > 0) name[0] = '\0';
+      return name;
+    }
+    cached->block = block;
+  }
+  cached->lastUsed = ++_genreNameCacheClock;
+  if (size > 0) {
+    strncpy(name, cached->names + cached->offsets[index % _genreNameBlockSize], size - 1);
+    name[size - 1] = '\0';
+  }
+  return name;
+}
+
+// names are a byte with the length of the prefix shared with the previous name, then the rest of the name, see
+// front_code in load_genres.rb
+bool GenreCatalog::decodeNameBlock(const char *coded, const char *end, uint16_t count,
+                                   GenreNameCacheBlock_t *decoded) {
+  size_t length = 0;
+  size_t previousStart = 0;
+  size_t previousLength = 0;
+  for (auto i = 0; i < count; i++) {
+    if (end && coded >= end) return false;
+    const size_t shared = (uint8_t)*coded++;
+    const size_t start = length;
+    if (shared > previousLength || start + shared >= GENRE_NAME_CACHE_BLOCK_BYTES) return false;
+    memcpy(decoded->names + start, decoded->names + previousStart, shared);
+    length += shared;
+    const size_t available = GENRE_NAME_CACHE_BLOCK_BYTES - length;
+    const size_t suffix = strnlen(coded, end ? min(available, (size_t)(end - coded)) : available);
+    if (suffix == available || (end && coded + suffix >= end)) return false;
+    memcpy(decoded->names + length, coded, suffix + 1);
+    coded += suffix + 1;
+    length += suffix + 1;
+    decoded->offsets[i] = start;
+    previousStart = start;
+    previousLength = length - start - 1;
+  }
+  return true;
+}
+
+void GenreCatalog::clearNameCache() {
+  GenreNameCacheLock lock(_genreNameCacheLock);
+  for (auto &entry : _genreNameCache) {
+    entry.block = -1;
+    entry.lastUsed = 0;
+  }
+  _genreNameCacheClock = 0;
+}
+
+// must match prefix_class in load_genres.rb
+static uint16_t prefixClass(char c) {
+  const uint8_t byte = c;
+  if (byte < '0') return 0;
+  if (byte <= '9') return byte - '0' + 1;
+  if (byte < 'a') return 11;
+  if (byte <= 'z') return byte - 'a' + 12;
+  return 38;
+}
+
+static uint16_t namePrefixKey(const char *name) {
+  return prefixClass(name[0]) * GENRE_PREFIX_CLASSES + (name[0] == '\0' ? 0 : prefixClass(name[1]));
+}
+
+// starts must be nondecreasing and end at count, with each name inside the range for its own key, so jumps always
+// land on an index below count
+static bool isValidPrefixRange(const uint16_t *starts, uint16_t index, uint16_t key) {
+  return key < GENRE_PREFIX_CLASSES * GENRE_PREFIX_CLASSES && starts[key] <= index && index < starts[key + 1];
+}
+
+static bool isValidPrefixStarts(const uint16_t *starts, uint16_t count) {
+  const size_t keys = GENRE_PREFIX_CLASSES * GENRE_PREFIX_CLASSES;
+  for (size_t key = 0; key < keys; key++) {
+    if (starts[key] > starts[key + 1]) return false;
+  }
+  return starts[keys] == count;
+}
+
+uint16_t GenreCatalog::prefixKey(bool countries, uint16_t index, bool firstLetter) {
+  uint16_t key;
+  if (countries) {
+    key = _countryPrefixKeys[index];
+  } else {
+    char name[3];
+    key = namePrefixKey(genreName(index, name, sizeof(name)));
+  }
+  return firstLetter ? key - key % GENRE_PREFIX_CLASSES : key;
+}
+
+uint16_t GenreCatalog::prefixJump(bool countries, uint16_t index, int direction, bool firstLetter) {
+  const uint16_t *starts = countries ? _countryPrefixStarts : _genrePrefixStarts;
+  const uint16_t count = countries ? _countryCount : _genreCount;
+  const uint16_t key = prefixKey(countries, index, firstLetter);
+  if (direction > 0) {
+    const uint16_t next = starts[key + (firstLetter ? GENRE_PREFIX_CLASSES : 1)];
+    return next < count ? next : 0;
+  }
+  // back to the start of this group first, then to the start of the one before it
+  if (index > starts[key]) return starts[key];
+  return starts[prefixKey(countries, index == 0 ? count - 1 : index - 1, firstLetter)];
+}
+
+bool GenreCatalog::isValid(const uint8_t *data, size_t size) {
+  auto header = (const GenreCatalogHeader_t *)data;
+  if (size < sizeof(GenreCatalogHeader_t) || header->magic != GENRE_CATALOG_MAGIC ||
+      header->format != GENRE_CATALOG_FORMAT || header->headerSize != sizeof(GenreCatalogHeader_t) ||
+      header->size < header->headerSize || header->size > size) {
+    return false;
+  }
+  if (esp_rom_crc32_le(0, data + header->headerSize, header->size - header->headerSize) != header->crc) {
+    log_e("catalog checksum mismatch");
+    return false;
+  }
+
+  auto fits = [header](uint32_t offset, size_t length, size_t alignment) {
+    return offset >= header->headerSize && offset % alignment == 0 && offset + length <= header->size;
+  };
+  const size_t genres = header->genreCount;
+  const size_t countries = header->countryCount;
+  const size_t blockSize = header->genreNameBlockSize;
+  const size_t blocks = blockSize > 0 ? (genres + blockSize - 1) / blockSize : 0;
+  const size_t prefixStartsSize = GENRE_PREFIX_CLASSES * GENRE_PREFIX_CLASSES + 1;
+  if (genres == 0 || countries == 0 || blocks == 0 || blockSize > GENRE_NAME_CACHE_BLOCK_NAMES ||
+      header->playlistHashBuckets == 0 ||
+      header->playlistHashSize < 2 || !fits(header->genreNames, 1, 1) || !fits(header->countryNames, 1, 1) ||
+      !fits(header->genreNameBlockOffsets, blocks * sizeof(uint32_t), alignof(uint32_t)) ||
+      !fits(header->genrePlaylists, genres * sizeof(SpotifyId), alignof(SpotifyId)) ||
+      !fits(header->genreColors, genres * sizeof(uint16_t), alignof(uint16_t)) ||
+      !fits(header->countryNameOffsets, countries * sizeof(uint16_t), alignof(uint16_t)) ||
+      !fits(header->countryPlaylists, countries * sizeof(SpotifyId), alignof(SpotifyId)) ||
+      !fits(header->playlistHashDisplacements, header->playlistHashBuckets * sizeof(uint16_t), alignof(uint16_t)) ||
+      !fits(header->playlistHashEntities, header->playlistHashSize * sizeof(uint16_t), alignof(uint16_t)) ||
+      !fits(header->genrePrefixStarts, prefixStartsSize * sizeof(uint16_t), alignof(uint16_t)) ||
+      !fits(header->countryPrefixKeys, countries * sizeof(uint16_t), alignof(uint16_t)) ||
+      !fits(header->countryPrefixStarts, prefixStartsSize * sizeof(uint16_t), alignof(uint16_t)) ||
+      (header->genreNeighborCount > 0 &&
+       !fits(header->genreNeighbors, genres * header->genreNeighborCount * sizeof(uint16_t), alignof(uint16_t))) ||
+      (header->genrePopularityAliases != 0 &&
+       !fits(header->genrePopularityAliases, genres * sizeof(uint32_t), alignof(uint32_t))) ||
+      (header->textLayoutCount > 0 && !fits(header->textLayouts,
+                                            header->textLayoutCount * sizeof(GenreCatalogTextLayout_t),
+                                            alignof(GenreCatalogTextLayout_t))) ||
+      !fits(header->orders, header->orderCount * sizeof(GenreCatalogOrder_t), alignof(GenreCatalogOrder_t))) {
+    log_e("catalog sections out of bounds");
+    return false;
+  }
+
+  auto orders = (const GenreCatalogOrder_t *)(data + header->orders);
+  for (auto i = 0; i < header->orderCount; i++) {
+    if (orders[i].sortMode >= genreSortModesCount ||
+        !fits(orders[i].genreIndexes, genres * sizeof(uint16_t), alignof(uint16_t)) ||
+        !fits(orders[i].genreMenuIndexes, genres * sizeof(uint16_t), alignof(uint16_t))) {
+      log_e("catalog order %d out of bounds", i);
+      return false;
+    }
+    // each order has to be a permutation of the genres, with menu indexes as its inverse
+    auto indexes = (const uint16_t *)(data + orders[i].genreIndexes);
+    auto menuIndexes = (const uint16_t *)(data + orders[i].genreMenuIndexes);
+    for (size_t j = 0; j < genres; j++) {
+      if (indexes[j] >= genres || menuIndexes[indexes[j]] != j) {
+        log_e("catalog order %d index %u is invalid", i, j);
+        return false;
+      }
+    }
+  }
+
+  auto textLayouts = (const GenreCatalogTextLayout_t *)(data + header->textLayouts);
+  for (auto i = 0; i < header->textLayoutCount; i++) {
+    if (!fits(textLayouts[i].genreLayouts, genres * sizeof(uint32_t), alignof(uint32_t)) ||
+        !fits(textLayouts[i].countryLayouts, countries * sizeof(uint32_t), alignof(uint32_t))) {
+      log_e("catalog text layout %d out of bounds", i);
+      return false;
+    }
+  }
+
+  // country names follow one another from the start of their section, see string_offsets in load_genres.rb
+  auto countryNameOffsets = (const uint16_t *)(data + header->countryNameOffsets);
+  const size_t countryNamesSize = header->size - header->countryNames;
+  size_t countryNamesEnd = 0;
+  for (size_t i = 0; i < countries; i++) {
+    const size_t available = countryNamesSize - countryNamesEnd;
+    const size_t length = strnlen((const char *)data + header->countryNames + countryNamesEnd, available);
+    if (countryNameOffsets[i] != countryNamesEnd || length == available) {
+      log_e("catalog country name %u out of bounds", i);
+      return false;
+    }
+    countryNamesEnd += length + 1;
+  }
+
+  auto genrePrefixStarts = (const uint16_t *)(data + header->genrePrefixStarts);
+  auto countryPrefixKeys = (const uint16_t *)(data + header->countryPrefixKeys);
+  auto countryPrefixStarts = (const uint16_t *)(data + header->countryPrefixStarts);
+  if (!isValidPrefixStarts(genrePrefixStarts, genres) || !isValidPrefixStarts(countryPrefixStarts, countries)) {
+    log_e("catalog prefix starts are invalid");
+    return false;
+  }
+  for (size_t i = 0; i < countries; i++) {
+    if (!isValidPrefixRange(countryPrefixStarts, i, countryPrefixKeys[i])) {
+      log_e("catalog country prefix key %u is invalid", i);
+      return false;
+    }
+  }
+
+  auto blockOffsets = (const uint32_t *)(data + header->genreNameBlockOffsets);
+  GenreNameCacheBlock_t decoded;
+  for (size_t i = 0; i < blocks; i++) {
+    const uint16_t count = min(blockSize, genres - i * blockSize);
+    if (blockOffsets[i] >= header->size - header->genreNames ||
+        !decodeNameBlock((const char *)data + header->genreNames + blockOffsets[i], (const char *)data + header->size,
+                         count, &decoded)) {
+      log_e("catalog genre name block %u is invalid", i);
+      return false;
+    }
+    for (size_t j = 0; j < count; j++) {
+      const size_t index = i * blockSize + j;
+      if (!isValidPrefixRange(genrePrefixStarts, index, namePrefixKey(decoded.names + decoded.offsets[j]))) {
+        log_e("catalog genre prefix start for %u is invalid", index);
+        return false;
+      }
+    }
+  }
+
+  auto neighbors = (const uint16_t *)(data + header->genreNeighbors);
+  for (size_t i = 0; i < genres * header->genreNeighborCount; i++) {
+    if (neighbors[i] >= genres) {
+      log_e("catalog genre neighbor %u out of bounds", i);
+      return false;
+    }
+  }
+
+  if (header->genrePopularityAliases != 0) {
+    auto aliases = (const uint32_t *)(data + header->genrePopularityAliases);
+    for (size_t i = 0; i < genres; i++) {
+      if (aliases[i] >> 16 >= genres) {
+        log_e("catalog genre popularity alias %u out of bounds", i);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+void GenreCatalog::load(const uint8_t *data) {
+  auto header = (const GenreCatalogHeader_t *)data;
+  _version = header->version;
+  _genreCount = header->genreCount;
+  _countryCount = header->countryCount;
+  _playlistHashBuckets = header->playlistHashBuckets;
+  _playlistHashSize = header->playlistHashSize;
+  _genreNameBlockSize = header->genreNameBlockSize;
+  clearNameCache();
+  _genreNames = (const char *)(data + header->genreNames);
+  _genreNameBlockOffsets = (const uint32_t *)(data + header->genreNameBlockOffsets);
+  _genrePlaylists = (const SpotifyId *)(data + header->genrePlaylists);
+  _genreColors = (const uint16_t *)(data + header->genreColors);
+  _countryNames = (const char *)(data + header->countryNames);
+  _countryNameOffsets = (const uint16_t *)(data + header->countryNameOffsets);
+  _countryPlaylists = (const SpotifyId *)(data + header->countryPlaylists);
+  _playlistHashDisplacements = (const uint16_t *)(data + header->playlistHashDisplacements);
+  _playlistHashEntities = (const uint16_t *)(data + header->playlistHashEntities);
+  _genrePrefixStarts = (const uint16_t *)(data + header->genrePrefixStarts);
+  _countryPrefixKeys = (const uint16_t *)(data + header->countryPrefixKeys);
+  _countryPrefixStarts = (const uint16_t *)(data + header->countryPrefixStarts);
+  _genreNeighborCount = header->genreNeighborCount;
+  _genreNeighbors = _genreNeighborCount > 0 ? (const uint16_t *)(data + header->genreNeighbors) : nullptr;
+  _genrePopularityAliases =
+      header->genrePopularityAliases != 0 ? (const uint32_t *)(data + header->genrePopularityAliases) : nullptr;
+  _data = data;
+  _textLayoutCount = header->textLayoutCount;
+  _textLayouts = _textLayoutCount > 0 ? (const GenreCatalogTextLayout_t *)(data + header->textLayouts) : nullptr;
+  _genreTextLayouts = nullptr;
+  _countryTextLayouts = nullptr;
+
+  for (auto i = 0; i < genreSortModesCount; i++) {
+    _genreIndexes[i] = nullptr;
+    _genreMenuIndexes[i] = nullptr;
+  }
+  auto orders = (const GenreCatalogOrder_t *)(data + header->orders);
+  for (auto i = 0; i < header->orderCount; i++) {
+    if (orders[i].sortMode == AlphabeticSort) continue;
+    _genreIndexes[orders[i].sortMode] = (const uint16_t *)(data + orders[i].genreIndexes);
+    _genreMenuIndexes[orders[i].sortMode] = (const uint16_t *)(data + orders[i].genreMenuIndexes);
+  }
+  _usingPartition = true;
+}
+
+bool GenreCatalog::beginUpdate(size_t size) {
+  if (!_partition) {
+    log_e("no catalog partition to update");
+    return false;
+  }
+  if (size > _partition->size) {
+    log_e("catalog is too large: %u > %u", size, _partition->size);
+    return false;
+  }
+  // the loop switches to the built-in catalog first, nothing else can be reading the partition while it's erased
+  if (_usingPartition) {
+    log_e("catalog partition is still in use");
+    return false;
+  }
+  _updateSize = size;
+  _updateWritten = 0;
+  _updateErased = 0;
+  return true;
+}
+
+bool GenreCatalog::writeUpdate(const uint8_t *data, size_t length) {
+  if (!_partition || _updateWritten + length > _partition->size) return false;
+  while (_updateErased < _updateWritten + length) {
+    if (esp_partition_erase_range(_partition, _updateErased, SPI_FLASH_SEC_SIZE) != ESP_OK) return false;
+    _updateErased += SPI_FLASH_SEC_SIZE;
+  }
+  if (esp_partition_write(_partition, _updateWritten, data, length) != ESP_OK) return false;
+  _updateWritten += length;
+  return true;
+}
+
+bool GenreCatalog::endUpdate() {
+  if (!_partition || _updateWritten == 0 || (_updateSize > 0 && _updateWritten != _updateSize)) return false;
+
+  const void *data = nullptr;
+  spi_flash_mmap_handle_t handle;
+  if (esp_partition_mmap(_partition, 0, _updateWritten, SPI_FLASH_MMAP_DATA, &data, &handle) != ESP_OK) return false;
+  const bool valid = isValid((const uint8_t *)data, _updateWritten);
+  spi_flash_munmap(handle);
+  return valid;
+}
+
+GenreCatalog genreCatalog;
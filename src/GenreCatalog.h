@@ -0,0 +1,201 @@
+#pragma once
+
+#include <esp_partition.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "SpotifyId.h"
+
+#define GENRE_CATALOG_MAGIC 0x54434e4b  // "KNCT"
+#define GENRE_CATALOG_FORMAT 6
+#define GENRE_CATALOG_PARTITION_LABEL "catalog"
+#define GENRE_CATALOG_PARTITION_SUBTYPE 0x40
+
+// decoded blocks of front coded genre names, GENRE_NAME_CACHE_BLOCK_BYTES must match load_genres.rb
+#define GENRE_NAME_CACHE_BLOCKS 4
+#define GENRE_NAME_CACHE_BLOCK_NAMES 16
+#define GENRE_NAME_CACHE_BLOCK_BYTES 512
+// enough for the longest genre name, longer ones are cut off
+#define GENRE_NAME_SIZE 64
+
+enum GenreSortModes {
+  AlphabeticSort = 0,
+  AlphabeticSuffixSort = 1,
+  BackgroundSort = 2,
+  ModernitySort = 3,
+  PopularitySort = 4
+};
+const int genreSortModesCount = 5;
+
+// layout of a catalog written by load_genres.rb, offsets are from the start of the header
+typedef struct {
+  uint32_t magic;
+  uint16_t format;
+  uint16_t headerSize;
+  uint32_t version;
+  uint32_t size;
+  uint32_t crc;  // crc32 of everything after the header
+  uint16_t genreCount;
+  uint16_t countryCount;
+  uint16_t playlistHashBuckets;
+  uint16_t playlistHashSize;
+  uint16_t genreNameBlockSize;
+  uint16_t orderCount;
+  uint16_t genreNeighborCount;  // neighbors per genre, 0 if the catalog has none
+  uint16_t textLayoutCount;
+  uint32_t genreNames;
+  uint32_t genreNameBlockOffsets;
+  uint32_t genrePlaylists;
+  uint32_t genreColors;
+  uint32_t countryNames;
+  uint32_t countryNameOffsets;
+  uint32_t countryPlaylists;
+  uint32_t playlistHashDisplacements;
+  uint32_t playlistHashEntities;
+  uint32_t genrePrefixStarts;
+  uint32_t countryPrefixKeys;
+  uint32_t countryPrefixStarts;
+  uint32_t genreNeighbors;
+  uint32_t genrePopularityAliases;  // 0 if the catalog has none
+  uint32_t textLayouts;
+  uint32_t orders;
+} GenreCatalogHeader_t;
+
+typedef struct {
+  uint16_t sortMode;
+  uint16_t reserved;
+  uint32_t genreIndexes;
+  uint32_t genreMenuIndexes;
+} GenreCatalogOrder_t;
+
+static_assert(sizeof(GenreCatalogHeader_t) == 100, "unexpected catalog header size");
+typedef struct {
+  uint16_t textWidth;
+  uint16_t spaceWidth;
+  uint32_t genreLayouts;
+  uint32_t countryLayouts;
+} GenreCatalogTextLayout_t;
+
+static_assert(sizeof(GenreCatalogOrder_t) == 12, "unexpected catalog order size");
+static_assert(sizeof(GenreCatalogTextLayout_t) == 12, "unexpected catalog text layout size");
+
+typedef struct {
+  int32_t block = -1;
+  uint32_t lastUsed = 0;
+  uint16_t offsets[GENRE_NAME_CACHE_BLOCK_NAMES];
+  char names[GENRE_NAME_CACHE_BLOCK_BYTES];
+} GenreNameCacheBlock_t;
+
+// Line breaks worked out by load_genres.rb for drawCenteredText: where the second line starts (or the name's length
+// if it fits on one line), and the width of each line. A layout of 0 means the name has to be measured as it's drawn.
+inline uint8_t textLayoutBreak(uint32_t layout) { return layout & 0x7f; }
+inline uint16_t textLayoutWidth(uint32_t layout, int line) { return (layout >> (7 + 9 * line)) & 0x1ff; }
+
+// Genre and country tables, read in place from the catalog partition when it holds a valid catalog at least as new
+// as the one built into the firmware, or from genres.h otherwise.
+class GenreCatalog {
+ public:
+  void setup();
+  void useBuiltIn();
+
+  bool isBuiltIn() { return !_usingPartition; }
+  uint32_t version() { return _version; }
+  uint16_t genreCount() { return _genreCount; }
+  uint16_t countryCount() { return _countryCount; }
+
+  // decoded into a small cache shared by the loop and background task, then copied into name, which is returned
+  const char *genreName(uint16_t index, char *name, size_t size);
+  const SpotifyId &genrePlaylist(uint16_t index) { return _genrePlaylists[index]; }
+  uint16_t genreColor(uint16_t index) { return _genreColors[index]; }
+  const char *countryName(uint16_t index) { return _countryNames + _countryNameOffsets[index]; }
+  const SpotifyId &countryPlaylist(uint16_t index) { return _countryPlaylists[index]; }
+
+  // menu index to genre index for a sort mode, or nullptr when it's alphabetic or not in the catalog
+  const uint16_t *genreIndexes(GenreSortModes sort);
+  // genre index to menu index, the inverse of genreIndexes
+  const uint16_t *genreMenuIndexes(GenreSortModes sort);
+
+  // genres closest to a genre by their rankings, nearest first, or nullptr when the catalog doesn't have them
+  const uint16_t *genreNeighbors(uint16_t index) {
+    return _genreNeighborCount > 0 ? _genreNeighbors + index * _genreNeighborCount : nullptr;
+  }
+  uint16_t genreNeighborCount() { return _genreNeighborCount; }
+
+  // a random genre, weighted by popularity if asked and the catalog has an alias table for it, uniform otherwise
+  uint16_t randomGenre(bool byPopularity);
+  bool hasPopularityWeights() { return _genrePopularityAliases != nullptr; }
+
+  // pick the layouts measured for this text width and font, returns false if the catalog doesn't have them
+  bool useTextLayouts(uint16_t textWidth, uint16_t spaceWidth);
+  uint32_t genreTextLayout(uint16_t index) { return _genreTextLayouts ? _genreTextLayouts[index] : 0; }
+  uint32_t countryTextLayout(uint16_t index) { return _countryTextLayouts ? _countryTextLayouts[index] : 0; }
+
+  // start of the next or previous group of alphabetically sorted names sharing a first letter, or first two letters
+  uint16_t genrePrefixJump(uint16_t index, int direction, bool firstLetter) {
+    return prefixJump(false, index, direction, firstLetter);
+  }
+  uint16_t countryPrefixJump(uint16_t index, int direction, bool firstLetter) {
+    return prefixJump(true, index, direction, firstLetter);
+  }
+
+  // genre playlists are entities 0 to genreCount() - 1, followed by country playlists, or -1 if not found
+  int findPlaylist(const SpotifyId &id);
+
+  // write a new catalog to the partition, it's loaded on the next restart, after switching to the built-in catalog
+  // with useBuiltIn while nothing else is reading from the partition
+  bool beginUpdate(size_t size);
+  bool writeUpdate(const uint8_t *data, size_t length);
+  bool endUpdate();
+
+ protected:
+  static bool isValid(const uint8_t *data, size_t size);
+  static bool decodeNameBlock(const char *coded, const char *end, uint16_t count, GenreNameCacheBlock_t *decoded);
+  void clearNameCache();
+  uint16_t prefixKey(bool countries, uint16_t index, bool firstLetter);
+  uint16_t prefixJump(bool countries, uint16_t index, int direction, bool firstLetter);
+  void load(const uint8_t *data);
+
+  const esp_partition_t *_partition = nullptr;
+  spi_flash_mmap_handle_t _mappedHandle = 0;
+  bool _mapped = false;
+  bool _usingPartition = false;
+  size_t _updateSize = 0;
+  size_t _updateWritten = 0;
+  size_t _updateErased = 0;
+
+  uint32_t _version = 0;
+  uint16_t _genreCount = 0;
+  uint16_t _countryCount = 0;
+  uint16_t _playlistHashBuckets = 0;
+  uint16_t _playlistHashSize = 0;
+  uint16_t _genreNameBlockSize = 1;
+  uint16_t _genreNeighborCount = 0;
+  const char *_genreNames = nullptr;
+  const uint32_t *_genreNameBlockOffsets = nullptr;
+  const SpotifyId *_genrePlaylists = nullptr;
+  const uint16_t *_genreColors = nullptr;
+  const char *_countryNames = nullptr;
+  const uint16_t *_countryNameOffsets = nullptr;
+  const SpotifyId *_countryPlaylists = nullptr;
+  const uint16_t *_playlistHashDisplacements = nullptr;
+  const uint16_t *_playlistHashEntities = nullptr;
+  const uint16_t *_genrePrefixStarts = nullptr;
+  const uint16_t *_countryPrefixKeys = nullptr;
+  const uint16_t *_countryPrefixStarts = nullptr;
+  const uint16_t *_genreNeighbors = nullptr;
+  const uint32_t *_genrePopularityAliases = nullptr;
+  const uint8_t *_data = nullptr;
+  uint16_t _textLayoutCount = 0;
+  const GenreCatalogTextLayout_t *_textLayouts = nullptr;
+  const uint32_t *_genreTextLayouts = nullptr;
+  const uint32_t *_countryTextLayouts = nullptr;
+  const uint16_t *_genreIndexes[genreSortModesCount] = {};
+  const uint16_t *_genreMenuIndexes[genreSortModesCount] = {};
+  SemaphoreHandle_t _genreNameCacheLock = nullptr;
+  GenreNameCacheBlock_t _genreNameCache[GENRE_NAME_CACHE_BLOCKS];
+  uint32_t _genreNameCacheClock = 0;
+};
+
+extern GenreCatalog genreCatalog;
@@ -0,0 +1,193 @@
+#include "GlyphSprite.h"
+
+GlyphBlendRamp_t GlyphSprite::_blendRamps[GLYPH_BLEND_RAMPS];
+uint32_t GlyphSprite::_blendClock = 0;
+uint16_t GlyphSprite::_paletteShades[256];
+uint16_t GlyphSprite::_expanded[GLYPH_PALETTE_EXPAND_PIXELS];
+
+void GlyphSprite::loadFont(const uint8_t array[]) {
+  TFT_eSprite::loadFont(array);
+  buildGlyphTables();
+}
+
+void GlyphSprite::unloadFont() {
+  TFT_eSprite::unloadFont();
+  freeGlyphTables();
+}
+
+void GlyphSprite::buildGlyphTables() {
+  freeGlyphTables();
+  if (!fontLoaded) return;
+
+  uint16_t hashCount = 0;
+  for (uint16_t i = 0; i < gFont.gCount; i++) {
+    if (gUnicode[i] >= GLYPH_LATIN_COUNT) hashCount++;
+  }
+  if (hashCount > 0) {
+    // at most half full, so probes stay short
+    _glyphHashBits = 1;
+    while ((1 << _glyphHashBits) < hashCount * 2) _glyphHashBits++;
+    _glyphHash = (uint16_t *)malloc(sizeof(uint16_t) << _glyphHashBits);
+    if (!_glyphHash) {
+      log_e("no memory for glyph table, using getUnicodeIndex");
+      _glyphHashBits = 0;
+      return;
+    }
+    memset(_glyphHash, 0xff, sizeof(uint16_t) << _glyphHashBits);
+  }
+
+  // the first glyph for a code point wins, like getUnicodeIndex
+  const uint16_t mask = (1 << _glyphHashBits) - 1;
+  for (uint16_t i = 0; i < gFont.gCount; i++) {
+    const uint16_t unicode = gUnicode[i];
+    if (unicode < GLYPH_LATIN_COUNT) {
+      if (_latinGlyphs[unicode] == GLYPH_NOT_FOUND) _latinGlyphs[unicode] = i;
+      continue;
+    }
+    uint16_t slot = glyphSlot(unicode);
+    while (_glyphHash[slot] != GLYPH_NOT_FOUND && gUnicode[_glyphHash[slot]] != unicode) slot = (slot + 1) & mask;
+    if (_glyphHash[slot] == GLYPH_NOT_FOUND) _glyphHash[slot] = i;
+  }
+}
+
+void GlyphSprite::freeGlyphTables() {
+  memset(_latinGlyphs, 0xff, sizeof(_latinGlyphs));
+  free(_glyphHash);
+  _glyphHash = nullptr;
+  _glyphHashBits = 0;
+}
+
+uint16_t GlyphSprite::findGlyph(uint16_t unicode) {
+  if (!_glyphHash) {
+    uint16_t index;
+    return fontLoaded && getUnicodeIndex(unicode, &index) ? index : GLYPH_NOT_FOUND;
+  }
+  const uint16_t mask = (1 << _glyphHashBits) - 1;
+  for (uint16_t slot = glyphSlot(unicode);; slot = (slot + 1) & mask) {
+    const uint16_t index = _glyphHash[slot];
+    if (index == GLYPH_NOT_FOUND || gUnicode[index] == unicode) return index;
+  }
+}
+
+// TFT_eSPI::drawGlyph with the glyph found through glyphIndex, anything that isn't a plain glyph in the font is
+// left to it
+void GlyphSprite::drawGlyph(uint16_t code) {
+  uint16_t gNum;
+  if (code < 0x21 || !glyphIndex(code, &gNum)) {
+    TFT_eSprite::drawGlyph(code);
+    return;
+  }
+
+  uint16_t fg = textcolor;
+  uint16_t bg = textbgcolor;
+  const bool getBackground = fg == bg && !paletted();
+  const uint16_t *ramp = nullptr;
+  if (paletted()) {
+    // drawn in shades of the palette instead of colors
+    setPaletteRamp(fg, bg);
+    fg = 15;
+    ramp = _paletteShades;
+  } else if (!getBackground) {
+    ramp = blendRamp(fg, bg);
+  }
+
+  if (textwrapX && (cursor_x + gWidth[gNum] + gdX[gNum] > width())) {
+    cursor_y += gFont.yAdvance;
+    cursor_x = 0;
+  }
+  if (textwrapY && ((cursor_y + gFont.yAdvance) >= height())) cursor_y = 0;
+  if (cursor_x == 0) cursor_x -= gdX[gNum];
+
+  const uint8_t *bitmap = gFont.gArray + gBitmap[gNum];
+  const int16_t cy = cursor_y + gFont.maxAscent - gdY[gNum];
+  const int16_t cx = cursor_x + gdX[gNum];
+  int16_t xs = cx;
+  uint32_t dl = 0;
+
+  startWrite();
+  for (int y = 0; y < gHeight[gNum]; y++) {
+    for (int x = 0; x < gWidth[gNum]; x++) {
+      const uint8_t pixel = pgm_read_byte(bitmap + x + gWidth[gNum] * y);
+      if (pixel == 0xff) {
+        if (dl == 0) xs = x + cx;
+        dl++;
+        continue;
+      }
+      if (dl) {
+        drawFastHLine(xs, y + cy, dl, fg);
+        dl = 0;
+      }
+      if (pixel) {
+        if (getBackground) {
+          bg = readPixel(x + cx, y + cy);
+          drawPixel(x + cx, y + cy, alphaBlend(pixel, fg, bg));
+        } else {
+          drawPixel(x + cx, y + cy, ramp[pixel]);
+        }
+      }
+    }
+    if (dl) {
+      drawFastHLine(xs, y + cy, dl, fg);
+      dl = 0;
+    }
+  }
+  endWrite();
+  cursor_x += gxAdvance[gNum];
+}
+
+const uint16_t *GlyphSprite::blendRamp(uint16_t fg, uint16_t bg) {
+  GlyphBlendRamp_t *oldest = &_blendRamps[0];
+  for (auto &ramp : _blendRamps) {
+    if (ramp.lastUsed != 0 && ramp.fg == fg && ramp.bg == bg) {
+      ramp.lastUsed = ++_blendClock;
+      return ramp.colors;
+    }
+    if (ramp.lastUsed < oldest->lastUsed) oldest = &ramp;
+  }
+  oldest->fg = fg;
+  oldest->bg = bg;
+  oldest->lastUsed = ++_blendClock;
+  for (uint16_t alpha = 0; alpha < 256; alpha++) oldest->colors[alpha] = alphaBlend(alpha, fg, bg);
+  return oldest->colors;
+}
+
+void GlyphSprite::setPaletteRamp(uint16_t fg, uint16_t bg) {
+  if (_paletteShades[255] == 0) {
+    for (uint16_t alpha = 0; alpha < 256; alpha++) _paletteShades[alpha] = (alpha * 15 + 127) / 255;
+  }
+  if (_paletteSet && fg == _paletteFg && bg == _paletteBg) return;
+  const uint16_t *ramp = blendRamp(fg, bg);
+  uint16_t palette[16];
+  for (uint8_t shade = 0; shade < 16; shade++) {
+    palette[shade] = ramp[shade * 17];
+    _swappedPalette[shade] = (palette[shade] >> 8) | (palette[shade] << 8);
+  }
+  createPalette(palette, 16);
+  _paletteSet = true;
+  _paletteFg = fg;
+  _paletteBg = bg;
+}
+
+void GlyphSprite::pushPalette(DisplayBackend &display, int32_t x, int32_t y, int32_t sx, int32_t w, int32_t h) {
+  const uint8_t *pixels = (const uint8_t *)getPointer();
+  if (!pixels || w <= 0 || h <= 0) return;
+  if (!_paletteSet) setPaletteRamp(textcolor, textbgcolor);
+  const int32_t rowBytes = width() / 2;
+  const int32_t columns = min(w, (int32_t)GLYPH_PALETTE_EXPAND_PIXELS);
+  const int32_t rows = GLYPH_PALETTE_EXPAND_PIXELS / columns;
+  for (int32_t column = 0; column < w; column += columns) {
+    const int32_t chunkWidth = min(columns, w - column);
+    for (int32_t row = 0; row < h; row += rows) {
+      const int32_t chunkHeight = min(rows, h - row);
+      uint16_t *out = _expanded;
+      for (int32_t i = 0; i < chunkHeight; i++) {
+        const uint8_t *in = pixels + (row + i) * rowBytes;
+        // two pixels to a byte, the first in the high bits
+        for (int32_t c = sx + column; c < sx + column + chunkWidth; c++) {
+          *out++ = _swappedPalette[c & 1 ? in[c >> 1] & 0x0f : in[c >> 1] >> 4];
+        }
+      }
+      display.pushRegion(x + column, y + row, chunkWidth, chunkHeight, _expanded, chunkWidth);
+    }
+  }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <TFT_eSPI.h>
+
+#include "DisplayBackend.h"
+
+#define GLYPH_LATIN_COUNT 256
+#define GLYPH_NOT_FOUND 0xffff
+// enough for every text color drawn on the usual backgrounds, shared by all glyph sprites
+#define GLYPH_BLEND_RAMPS 6
+// 4 bit sprites are expanded to RGB565 through this many pixels at a time when they're pushed
+#define GLYPH_PALETTE_EXPAND_PIXELS 1024
+
+// every alphaBlend of a foreground over a background, indexed by glyph coverage
+typedef struct {
+  uint16_t fg;
+  uint16_t bg;
+  uint32_t lastUsed = 0;
+  uint16_t colors[256];
+} GlyphBlendRamp_t;
+
+// A sprite that finds smooth font glyphs through tables built when the font is loaded, instead of the linear search
+// through gUnicode that getUnicodeIndex does for every character drawn or measured. Code points below
+// GLYPH_LATIN_COUNT are indexed directly, the rest are in an open addressed hash of glyph indexes. Anti-aliased edges
+// are colored from a ramp built once per foreground and background, rather than blending every pixel.
+//
+// With a color depth of 4, the sprite holds glyph coverage instead of colors: 16 shades from the text background to
+// the text color, set from the text colors each time a glyph is drawn, so everything in it shares one pair of colors.
+// Clear it with color 0, the background shade. It takes a quarter of the memory of a 16 bit sprite and is expanded to
+// RGB565 when it's pushed.
+class GlyphSprite : public TFT_eSprite {
+ public:
+  explicit GlyphSprite(TFT_eSPI *tft) : TFT_eSprite(tft) { memset(_latinGlyphs, 0xff, sizeof(_latinGlyphs)); }
+  ~GlyphSprite() { freeGlyphTables(); }
+
+  // hide TFT_eSprite's, so the tables always match the loaded font
+  void loadFont(const uint8_t array[]);
+  void unloadFont();
+
+  // same as getUnicodeIndex
+  bool glyphIndex(uint16_t unicode, uint16_t *index) {
+    const uint16_t found = unicode < GLYPH_LATIN_COUNT ? _latinGlyphs[unicode] : findGlyph(unicode);
+    if (found == GLYPH_NOT_FOUND) return false;
+    *index = found;
+    return true;
+  }
+
+  void drawGlyph(uint16_t code) override;
+
+  bool paletted() { return getColorDepth() == 4; }
+  // push w by h pixels from sx, 0 of a 4 bit sprite, the width it was created with has to be even
+  void pushPalette(DisplayBackend &display, int32_t x, int32_t y, int32_t sx, int32_t w, int32_t h);
+
+ protected:
+  void buildGlyphTables();
+  void freeGlyphTables();
+  uint16_t findGlyph(uint16_t unicode);
+  uint16_t glyphSlot(uint16_t unicode) { return (uint16_t)(unicode * 40503u) >> (16 - _glyphHashBits); }
+  // the ramp for a pair of colors, replacing the least recently used one if it isn't built yet
+  const uint16_t *blendRamp(uint16_t fg, uint16_t bg);
+  void setPaletteRamp(uint16_t fg, uint16_t bg);
+
+  static GlyphBlendRamp_t _blendRamps[GLYPH_BLEND_RAMPS];
+  static uint32_t _blendClock;
+  // glyph coverage to the nearest of the 16 shades
+  static uint16_t _paletteShades[256];
+  static uint16_t _expanded[GLYPH_PALETTE_EXPAND_PIXELS];
+
+  uint16_t _latinGlyphs[GLYPH_LATIN_COUNT];
+  uint16_t *_glyphHash = nullptr;
+  uint8_t _glyphHashBits = 0;
+  bool _paletteSet = false;
+  uint16_t _paletteFg = 0;
+  uint16_t _paletteBg = 0;
+  // byte swapped, the order pushed to a display
+  uint16_t _swappedPalette[16];
+};
@@ -0,0 +1,48 @@
+#include "IconAtlas.h"
+
+bool IconAtlas::setup(uint16_t width, uint16_t height) {
+  const size_t size = ICON_ATLAS_CELLS * width * height * sizeof(uint16_t);
+#ifdef BOARD_HAS_PSRAM
+  _pixels = (uint16_t *)ps_malloc(size);
+#else
+  _pixels = (uint16_t *)malloc(size);
+#endif
+  if (!_pixels) {
+    log_e("no memory for %u byte icon atlas", size);
+    return false;
+  }
+  _width = width;
+  _height = height;
+  return true;
+}
+
+bool IconAtlas::draw(DisplayBackend &display, uint16_t icon, IconStates state, int32_t x, int32_t y) {
+  for (auto i = 0; i < ICON_ATLAS_CELLS; i++) {
+    if (_cells[i].icon != icon || _cells[i].state != state) continue;
+    _cells[i].lastUsed = ++_clock;
+    _hits++;
+    display.pushRegion(x, y, _width, _height, _pixels + i * _width * _height, _width);
+    return true;
+  }
+  _misses++;
+  return false;
+}
+
+void IconAtlas::store(uint16_t icon, IconStates state, const uint16_t *pixels, uint16_t stride) {
+  if (!_pixels || !pixels) return;
+  auto oldest = 0;
+  for (auto i = 0; i < ICON_ATLAS_CELLS; i++) {
+    if (_cells[i].icon == icon && _cells[i].state == state) {
+      oldest = i;
+      break;
+    }
+    if (_cells[i].lastUsed < _cells[oldest].lastUsed) oldest = i;
+  }
+  uint16_t *cell = _pixels + oldest * _width * _height;
+  for (auto y = 0; y < _height; y++) memcpy(cell + y * _width, pixels + y * stride, _width * sizeof(uint16_t));
+  _cells[oldest].icon = icon;
+  _cells[oldest].state = state;
+  _cells[oldest].lastUsed = ++_clock;
+}
+
+IconAtlas iconAtlas;
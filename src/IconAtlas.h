@@ -0,0 +1,55 @@
+#pragma once
+
+#include <TFT_eSPI.h>
+
+#include "DisplayBackend.h"
+
+// every state of every control row icon fits with PSRAM, otherwise enough for the row with some to spare
+#ifdef BOARD_HAS_PSRAM
+#define ICON_ATLAS_CELLS 96
+#else
+#define ICON_ATLAS_CELLS 8
+#endif
+
+// how drawIcon draws an icon, every combination of its flags looks like one of these
+enum IconStates {
+  IconNormal = 0,
+  IconSelected = 1,
+  IconDisabled = 2,
+  IconDisabledSelected = 3,
+  IconFilled = 4,
+  IconFilledSelected = 5,
+  IconClicked = 6
+};
+
+typedef struct {
+  uint16_t icon = 0;
+  int8_t state = -1;
+  uint32_t lastUsed = 0;
+} IconAtlasCell_t;
+
+// Icons already rendered into RGB565 cells in the byte order sprites push to the display, so drawing one again is a
+// copy to the display instead of rasterizing its glyph.
+class IconAtlas {
+ public:
+  bool setup(uint16_t width, uint16_t height);
+
+  // push the cell for an icon in a state, returns false if it hasn't been stored yet
+  bool draw(DisplayBackend &display, uint16_t icon, IconStates state, int32_t x, int32_t y);
+  // copy a rendered icon in, replacing the least recently used cell
+  void store(uint16_t icon, IconStates state, const uint16_t *pixels, uint16_t stride);
+
+  uint32_t hits() { return _hits; }
+  uint32_t misses() { return _misses; }
+
+ protected:
+  uint16_t *_pixels = nullptr;
+  uint16_t _width = 0;
+  uint16_t _height = 0;
+  IconAtlasCell_t _cells[ICON_ATLAS_CELLS];
+  uint32_t _clock = 0;
+  uint32_t _hits = 0;
+  uint32_t _misses = 0;
+};
+
+extern IconAtlas iconAtlas;
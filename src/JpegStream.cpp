@@ -0,0 +1,133 @@
+#include "JpegStream.h"
+
+JRESULT JpegStream::decode(Client *stream, int length, bool chunked, uint16_t *tile, uint16_t width,
+                           uint16_t height) {
+  _stream = stream;
+  _chunked = chunked;
+  _unbounded = !chunked && length < 0;
+  // a chunked body starts with the size of its first chunk
+  _remaining = chunked ? 0 : _unbounded ? SIZE_MAX : length;
+  _lastByteMillis = millis();
+  _bytesRead = 0;
+  _ended = false;
+  _tile = tile;
+  _width = width;
+  _height = height;
+
+  // TJpg_Decoder's tjpgd swaps bytes itself if swap is set, cleared here so output always swaps them
+  memset(&_jdec, 0, sizeof(_jdec));
+  JRESULT result = jd_prepare(&_jdec, input, _workspace, sizeof(_workspace), this);
+  if (result == JDR_MEM1) log_e("%u byte jpeg workspace is too small", sizeof(_workspace));
+  if (result == JDR_OK) result = jd_decomp(&_jdec, output, 0);
+  _stream = nullptr;
+  _tile = nullptr;
+  return result;
+}
+
+size_t JpegStream::input(JDEC *jdec, uint8_t *buffer, size_t length) {
+  JpegStream *self = (JpegStream *)jdec->device;
+  if (buffer) return self->read(buffer, length);
+
+  // skipping over a segment the decoder doesn't need still has to take it off the stream
+  uint8_t discard[64];
+  size_t skipped = 0;
+  while (skipped < length) {
+    const size_t read = self->read(discard, std::min(length - skipped, sizeof(discard)));
+    if (read == 0) break;
+    skipped += read;
+  }
+  return skipped;
+}
+
+size_t JpegStream::read(uint8_t *buffer, size_t length) {
+  size_t got = 0;
+  while (got < length) {
+    if (_remaining == 0 && (!_chunked || !nextChunk())) break;
+    const size_t read = readStream(buffer + got, std::min(length - got, _remaining));
+    if (read == 0) break;
+    if (!_unbounded) _remaining -= read;
+    got += read;
+  }
+  _bytesRead += got;
+  return got;
+}
+
+size_t JpegStream::readStream(uint8_t *buffer, size_t length) {
+  size_t got = 0;
+  while (got < length && !_ended) {
+    const int available = _stream->available();
+    if (available > 0) {
+      const int read = _stream->read(buffer + got, std::min(length - got, (size_t)available));
+      if (read > 0) {
+        got += read;
+        _lastByteMillis = millis();
+        continue;
+      }
+    }
+    // a short read ends the decode with JDR_INP, without waiting again if the decoder asks for more, and it's only
+    // cut off if part of a known length or chunk was still to come
+    if (!_stream->connected()) {
+      if (!_unbounded) log_e("jpeg stream closed after %u bytes", _bytesRead + got);
+      _ended = true;
+    } else if (millis() - _lastByteMillis > JPEG_STREAM_STALL_MILLIS) {
+      log_e("jpeg stream stalled after %u bytes", _bytesRead + got);
+      _ended = true;
+    } else {
+      delay(1);
+    }
+  }
+  return got;
+}
+
+// each chunk is its size in hex on a line of its own, then its data and a line break, and a size of 0 ends the body
+bool JpegStream::nextChunk() {
+  char line[JPEG_STREAM_CHUNK_LINE_SIZE];
+  size_t length = 0;
+  uint8_t c;
+  for (;;) {
+    if (readStream(&c, 1) == 0) return false;
+    if (c == '\r') continue;
+    if (c != '\n') {
+      if (length < sizeof(line) - 1) line[length++] = c;
+      continue;
+    }
+    // the line break after the last chunk's data
+    if (length > 0) break;
+  }
+  line[length] = '\0';
+
+  char *end;
+  const unsigned long size = strtoul(line, &end, 16);
+  if (end == line) {
+    log_e("invalid chunk size \"%s\" after %u bytes", line, _bytesRead);
+    _ended = true;
+    return false;
+  }
+  if (size == 0) {
+    _ended = true;
+    return false;
+  }
+  _remaining = size;
+  return true;
+}
+
+int JpegStream::output(JDEC *jdec, void *bitmap, JRECT *rect) {
+  JpegStream *self = (JpegStream *)jdec->device;
+  const uint16_t *pixels = (const uint16_t *)bitmap;
+  const uint16_t blockWidth = rect->right - rect->left + 1;
+  if (rect->top >= self->_height) return 1;
+  if (rect->left >= self->_width) return 1;
+  const uint16_t right = std::min((uint16_t)(rect->right + 1), self->_width);
+  const uint16_t bottom = std::min((uint16_t)(rect->bottom + 1), self->_height);
+  for (uint16_t y = rect->top; y < bottom; y++) {
+    const uint16_t *from = pixels + (y - rect->top) * blockWidth;
+    uint16_t *to = self->_tile + y * self->_width + rect->left;
+    for (uint16_t x = rect->left; x < right; x++) {
+      const uint16_t color = *from++;
+      *to++ = (color >> 8) | (color << 8);
+    }
+  }
+  return 1;
+}
+
+JpegStream jpegStream;
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Client.h>
+#include <tjpgd.h>
+
+// tjpgd R0.03 with its 512 byte input buffer needs about 3100 bytes, the fast huffman tables at JD_FASTDECODE 2 take
+// another 6KB
+#if defined(JD_FASTDECODE) && JD_FASTDECODE == 2
+#define JPEG_STREAM_WORKSPACE_SIZE (3100 + 6144)
+#else
+#define JPEG_STREAM_WORKSPACE_SIZE 3100
+#endif
+#if defined(JD_FORMAT) && JD_FORMAT != 1
+#error "JpegStream needs tjpgd to output RGB565"
+#endif
+// a response that stalls fails the decode instead of holding the background task
+#define JPEG_STREAM_STALL_MILLIS 4000
+// hex digits and any chunk extension
+#define JPEG_STREAM_CHUNK_LINE_SIZE 32
+
+// Decodes a JPEG while it's still arriving, with the decoder reading from the stream itself as it needs more bytes,
+// so nothing has to hold the whole file. Output goes into a width x height RGB565 tile, byte swapped for the display
+// and with anything outside the tile dropped.
+class JpegStream {
+ public:
+  // reads a body of length bytes from the client, or up to the end of a chunked body or the connection when length is
+  // negative, a response that closes, stops short or stalls fails with JDR_INP
+  JRESULT decode(Client *stream, int length, bool chunked, uint16_t *tile, uint16_t width, uint16_t height);
+
+  // bytes of the body read, not counting chunk sizes
+  uint32_t bytesRead() { return _bytesRead; }
+
+ protected:
+  static size_t input(JDEC *jdec, uint8_t *buffer, size_t length);
+  static int output(JDEC *jdec, void *bitmap, JRECT *rect);
+  // the body, without chunk sizes
+  size_t read(uint8_t *buffer, size_t length);
+  // whatever's on the connection, 0 once it closes or stalls
+  size_t readStream(uint8_t *buffer, size_t length);
+  bool nextChunk();
+
+  Client *_stream = nullptr;
+  bool _chunked = false;
+  // neither a length nor chunks, so the body ends when the connection closes
+  bool _unbounded = false;
+  // left in the body or the current chunk, unused for an unbounded body
+  size_t _remaining = 0;
+  unsigned long _lastByteMillis = 0;
+  uint32_t _bytesRead = 0;
+  bool _ended = false;
+  uint16_t *_tile = nullptr;
+  uint16_t _width = 0;
+  uint16_t _height = 0;
+  JDEC _jdec;
+  uint8_t _workspace[JPEG_STREAM_WORKSPACE_SIZE] __attribute__((aligned(4)));
+};
+
+extern JpegStream jpegStream;
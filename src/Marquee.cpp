@@ -0,0 +1,87 @@
+#include "Marquee.h"
+
+#include <esp_heap_caps.h>
+
+void Marquee::setup(const uint8_t font[], uint16_t lineHeight) {
+  _strip.setColorDepth(4);
+  _strip.loadFont(font);
+  _strip.setTextWrap(false, false);
+  _lineHeight = lineHeight;
+}
+
+uint32_t Marquee::textWidth(const char *text) {
+  const uint16_t len = strlen(text);
+  uint16_t pos = 0;
+  uint16_t index = 0;
+  uint32_t width = 0;
+  while (pos < len) {
+    const uint16_t unicode = _strip.decodeUTF8((uint8_t *)text, &pos, len - pos);
+    if (unicode == ' ') {
+      width += _strip.gFont.spaceWidth;
+    } else if (unicode > ' ' && _strip.glyphIndex(unicode, &index)) {
+      width += _strip.gxAdvance[index];
+    } else {
+      width += _strip.gFont.spaceWidth + 1;
+    }
+  }
+  return width;
+}
+
+bool Marquee::start(const char *text, uint32_t fgColor, uint32_t bgColor, int32_t x, int32_t y, uint16_t viewWidth,
+                    unsigned long now) {
+  if (_active && _text == text && _fgColor == fgColor && _bgColor == bgColor && _x == x && _y == y &&
+      _viewWidth == viewWidth) {
+    return true;
+  }
+  stop();
+
+  const uint32_t scrollWidth = textWidth(text) + MARQUEE_GAP;
+  // two pixels to a byte
+  const uint32_t stripWidth = (scrollWidth + viewWidth + 1) & ~1;
+  if (stripWidth > MARQUEE_MAX_WIDTH) return false;
+#ifndef BOARD_HAS_PSRAM
+  const size_t size = stripWidth * _lineHeight / 2;
+  if (heap_caps_get_largest_free_block(MALLOC_CAP_8BIT) < size + MARQUEE_HEAP_RESERVE) return false;
+#endif
+  if (!_strip.createSprite(stripWidth, _lineHeight)) {
+    log_e("unable to create %ux%u marquee", stripWidth, _lineHeight);
+    return false;
+  }
+
+  const uint16_t len = strlen(text);
+  _strip.fillSprite(0);
+  _strip.setTextColor(fgColor, bgColor);
+  _strip.setCursor(0, 0);
+  _strip.printToSprite((char *)text, len);
+  // again after the gap, cut off at the end of the strip
+  _strip.setCursor(scrollWidth, 0);
+  _strip.printToSprite((char *)text, len);
+
+  _active = true;
+  _text = text;
+  _fgColor = fgColor;
+  _bgColor = bgColor;
+  _x = x;
+  _y = y;
+  _viewWidth = viewWidth;
+  _scrollWidth = scrollWidth;
+  _startMillis = now;
+  return true;
+}
+
+void Marquee::draw(DisplayBackend &display, unsigned long now) {
+  if (!_active) return;
+  const unsigned long elapsed = now - _startMillis;
+  const uint32_t offset =
+      elapsed < MARQUEE_PAUSE_MILLIS
+          ? 0
+          : (uint64_t)(elapsed - MARQUEE_PAUSE_MILLIS) * MARQUEE_PIXELS_PER_SECOND / 1000 % _scrollWidth;
+  _strip.pushPalette(display, _x, _y, offset, _viewWidth, _lineHeight);
+}
+
+void Marquee::stop() {
+  if (!_active) return;
+  _strip.deleteSprite();
+  _active = false;
+  _text = "";
+}
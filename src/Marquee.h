@@ -0,0 +1,53 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "DisplayBackend.h"
+#include "GlyphSprite.h"
+
+#define MARQUEE_GAP 48
+#define MARQUEE_PIXELS_PER_SECOND 40
+#define MARQUEE_PAUSE_MILLIS 1500
+
+// any name fits with PSRAM, otherwise the strip has to come out of the heap TLS connections need, so it's capped at
+// about 40KB and only created if MARQUEE_HEAP_RESERVE would still be left
+#ifdef BOARD_HAS_PSRAM
+#define MARQUEE_MAX_WIDTH 8192
+#else
+#define MARQUEE_MAX_WIDTH 3072
+#define MARQUEE_HEAP_RESERVE (48 * 1024)
+#endif
+
+// Text too long to wrap onto the lines it has, rendered once on a single line into a strip sprite and scrolled through
+// a window by moving where each frame's push starts in the strip. The start of the text is rendered again after the
+// end so the window never has to wrap around, and every frame is one push of the window no matter how long the text is.
+// The strip is a 4 bit sprite of shades between the text colors, so it takes half a byte per pixel.
+class Marquee {
+ public:
+  explicit Marquee(TFT_eSPI *tft) : _strip(tft) {}
+
+  void setup(const uint8_t font[], uint16_t lineHeight);
+
+  // width of the text on one line, measured the way drawGlyph advances
+  uint32_t textWidth(const char *text);
+
+  // render the text to scroll through a viewWidth wide window, returns false if there's no room for it
+  bool start(const char *text, uint32_t fgColor, uint32_t bgColor, int32_t x, int32_t y, uint16_t viewWidth,
+             unsigned long now);
+  void draw(DisplayBackend &display, unsigned long now);
+  void stop();
+  bool active() { return _active; }
+
+ protected:
+  GlyphSprite _strip;
+  uint16_t _lineHeight = 0;
+  bool _active = false;
+  String _text;
+  uint32_t _fgColor = 0;
+  uint32_t _bgColor = 0;
+  int32_t _x = 0;
+  int32_t _y = 0;
+  uint16_t _viewWidth = 0;
+  uint32_t _scrollWidth = 0;
+  unsigned long _startMillis = 0;
+};
@@ -0,0 +1,103 @@
+#include "RenderProfiler.h"
+
+const char *renderTimingNames[] = {
+  "updateDisplay",
+  "drawSetup",
+  "drawRandomizing",
+  "drawRootMenu",
+  "drawSettingsMenu",
+  "drawUserMenu",
+  "drawDeviceMenu",
+  "drawVolumeControl",
+  "drawNowPlayingOrSeek",
+  "drawPlaylistsMenu",
+  "drawMenuHeader",
+  "drawStatusMessage",
+  "drawStatusOverlay",
+  "drawCenteredText",
+  "drawAlbumImage",
+  "drawIcon",
+  "drawBattery",
+  "drawDivider"
+};
+
+void RenderProfiler::add(RenderTimings timing, uint32_t cycles) {
+  const uint32_t micros = cycles / getCpuFrequencyMhz();
+  RenderTiming_t &t = _timings[timing];
+  t.count++;
+  t.minMicros = min(t.minMicros, micros);
+  t.maxMicros = max(t.maxMicros, micros);
+  t.totalMicros += micros;
+  uint16_t &samples = t.buckets[bucket(micros)];
+  if (samples < UINT16_MAX) samples++;
+}
+
+void RenderProfiler::reset() {
+  for (auto &timing : _timings) timing = RenderTiming_t();
+}
+
+uint32_t RenderProfiler::minMicros(RenderTimings timing) {
+  return _timings[timing].count > 0 ? _timings[timing].minMicros : 0;
+}
+
+uint32_t RenderProfiler::averageMicros(RenderTimings timing) {
+  return _timings[timing].count > 0 ? _timings[timing].totalMicros / _timings[timing].count : 0;
+}
+
+uint32_t RenderProfiler::p99Micros(RenderTimings timing) {
+  const RenderTiming_t &t = _timings[timing];
+  uint32_t total = 0;
+  for (auto samples : t.buckets) total += samples;
+  if (total == 0) return 0;
+  const uint32_t target = (total * 99 + 99) / 100;
+  uint32_t seen = 0;
+  for (uint8_t i = 0; i < RENDER_PROFILER_DOUBLINGS * RENDER_PROFILER_BUCKETS_PER_DOUBLING; i++) {
+    seen += t.buckets[i];
+    if (seen >= target) return min(bucketMicros(i), t.maxMicros);
+  }
+  return t.maxMicros;
+}
+
+void RenderProfiler::frameDrawn(unsigned long now) {
+  if (now - _secondStartMillis >= 1000) {
+    _framesLastSecond = now - _secondStartMillis < 2000 ? _framesThisSecond : 0;
+    _framesThisSecond = 0;
+    _secondStartMillis = now;
+  }
+  _framesThisSecond++;
+}
+
+uint16_t RenderProfiler::fps(unsigned long now) {
+  if (now - _secondStartMillis >= 2000) return 0;
+  if (now - _secondStartMillis >= 1000) return _framesThisSecond;
+  return _framesLastSecond;
+}
+
+void RenderProfiler::print(Print &output) {
+  output.printf("%-22s %8s %8s %8s %8s %8s\n", "us", "count", "min", "avg", "p99", "max");
+  for (auto i = 0; i < renderTimingsCount; i++) {
+    const RenderTimings timing = (RenderTimings)i;
+    if (count(timing) == 0) continue;
+    output.printf("%-22s %8u %8u %8u %8u %8u\n", renderTimingNames[i], count(timing), minMicros(timing),
+                  averageMicros(timing), p99Micros(timing), maxMicros(timing));
+  }
+}
+
+uint8_t RenderProfiler::bucket(uint32_t micros) {
+  // exact below 4us, then four buckets between each power of two
+  if (micros < RENDER_PROFILER_BUCKETS_PER_DOUBLING) return micros;
+  const uint8_t doubling = 31 - __builtin_clz(micros);
+  const uint8_t bucket = (doubling - 1) * RENDER_PROFILER_BUCKETS_PER_DOUBLING + ((micros >> (doubling - 2)) & 3);
+  return min(bucket, (uint8_t)(RENDER_PROFILER_DOUBLINGS * RENDER_PROFILER_BUCKETS_PER_DOUBLING - 1));
+}
+
+uint32_t RenderProfiler::bucketMicros(uint8_t bucket) {
+  // the largest time that lands in the bucket
+  if (bucket < RENDER_PROFILER_BUCKETS_PER_DOUBLING) return bucket;
+  const uint8_t doubling = bucket / RENDER_PROFILER_BUCKETS_PER_DOUBLING + 1;
+  const uint32_t lower = (uint32_t)(RENDER_PROFILER_BUCKETS_PER_DOUBLING + bucket % RENDER_PROFILER_BUCKETS_PER_DOUBLING)
+                         << (doubling - 2);
+  return lower + (1 << (doubling - 2)) - 1;
+}
+
+RenderProfiler renderProfiler;
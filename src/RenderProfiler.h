@@ -0,0 +1,82 @@
+#pragma once
+
+#include <Arduino.h>
+
+// samples are counted in buckets a quarter of a power of two wide, so p99 is at most 25% over the real thing
+#define RENDER_PROFILER_BUCKETS_PER_DOUBLING 4
+#define RENDER_PROFILER_DOUBLINGS 24
+
+// everything timed, each includes the time of anything it calls
+enum RenderTimings {
+  UpdateDisplayTiming = 0,
+  SetupTiming = 1,
+  RandomizingTiming = 2,
+  RootMenuTiming = 3,
+  SettingsMenuTiming = 4,
+  UserMenuTiming = 5,
+  DeviceMenuTiming = 6,
+  VolumeControlTiming = 7,
+  NowPlayingOrSeekTiming = 8,
+  PlaylistsMenuTiming = 9,
+  MenuHeaderTiming = 10,
+  StatusMessageTiming = 11,
+  StatusOverlayTiming = 12,
+  CenteredTextTiming = 13,
+  AlbumImageTiming = 14,
+  IconTiming = 15,
+  BatteryTiming = 16,
+  DividerTiming = 17
+};
+const int renderTimingsCount = 18;
+extern const char *renderTimingNames[];
+
+typedef struct {
+  uint32_t count = 0;
+  uint32_t minMicros = UINT32_MAX;
+  uint32_t maxMicros = 0;
+  uint64_t totalMicros = 0;
+  uint16_t buckets[RENDER_PROFILER_DOUBLINGS * RENDER_PROFILER_BUCKETS_PER_DOUBLING] = {};
+} RenderTiming_t;
+
+// How long each draw function takes, timed with the CPU cycle counter. The main loop and everything it draws stays on
+// one core at a fixed clock speed, so cycles convert straight to microseconds.
+class RenderProfiler {
+ public:
+  void add(RenderTimings timing, uint32_t cycles);
+  void reset();
+
+  uint32_t count(RenderTimings timing) { return _timings[timing].count; }
+  uint32_t minMicros(RenderTimings timing);
+  uint32_t averageMicros(RenderTimings timing);
+  uint32_t p99Micros(RenderTimings timing);
+  uint32_t maxMicros(RenderTimings timing) { return _timings[timing].maxMicros; }
+
+  // frames drawn in the last whole second
+  void frameDrawn(unsigned long now);
+  uint16_t fps(unsigned long now);
+
+  // a table of every timing that's been taken
+  void print(Print &output);
+
+ protected:
+  static uint8_t bucket(uint32_t micros);
+  static uint32_t bucketMicros(uint8_t bucket);
+
+  RenderTiming_t _timings[renderTimingsCount];
+  unsigned long _secondStartMillis = 0;
+  uint16_t _framesThisSecond = 0;
+  uint16_t _framesLastSecond = 0;
+};
+
+extern RenderProfiler renderProfiler;
+
+// times the scope it's declared in
+class RenderTimer {
+ public:
+  RenderTimer(RenderTimings timing) : _timing(timing), _start(ESP.getCycleCount()) {}
+  ~RenderTimer() { renderProfiler.add(_timing, ESP.getCycleCount() - _start); }
+
+ protected:
+  RenderTimings _timing;
+  uint32_t _start;
+};
@@ -0,0 +1,135 @@
+#include "ShadowFramebuffer.h"
+
+void ShadowFramebuffer::begin(uint16_t *frame, uint16_t *sent, int32_t width, int32_t height) {
+  _frame = frame;
+  _sent = sent;
+  resize(width, height);
+}
+
+void ShadowFramebuffer::resize(int32_t width, int32_t height) {
+  if (!_frame) return;
+  _width = width;
+  _height = height;
+  memset(_frame, 0, _width * _height * sizeof(uint16_t));
+  _resend = true;
+  dirty(0, _height);
+}
+
+void ShadowFramebuffer::pushRegion(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *pixels,
+                                   int32_t stride) {
+  const int32_t start = x < 0 ? -x : 0;
+  const int32_t end = x + w > _width ? _width - x : w;
+  if (end <= start) return;
+  const int32_t top = y < 0 ? 0 : y;
+  const int32_t bottom = y + h > _height ? _height : y + h;
+  for (int32_t row = top; row < bottom; row++) {
+    memcpy(_frame + row * _width + x + start, pixels + (row - y) * stride + start, (end - start) * sizeof(uint16_t));
+  }
+  dirty(top, bottom);
+}
+
+void ShadowFramebuffer::fillRegion(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) {
+  const uint16_t swapped = (uint16_t)((color >> 8) | (color << 8));
+  const int32_t left = x < 0 ? 0 : x;
+  const int32_t right = x + w > _width ? _width : x + w;
+  const int32_t top = y < 0 ? 0 : y;
+  const int32_t bottom = y + h > _height ? _height : y + h;
+  if (right <= left) return;
+  for (int32_t row = top; row < bottom; row++) {
+    uint16_t *pixel = _frame + row * _width + left;
+    for (int32_t column = left; column < right; column++) *pixel++ = swapped;
+  }
+  dirty(top, bottom);
+}
+
+void ShadowFramebuffer::drawPixel(int32_t x, int32_t y, uint32_t color) {
+  if (x < 0 || y < 0 || x >= _width || y >= _height) return;
+  _frame[y * _width + x] = (uint16_t)((color >> 8) | (color << 8));
+  dirty(y, y + 1);
+}
+
+uint32_t ShadowFramebuffer::flush(DisplayBackend &display) {
+  if (!_frame || _dirtyTop >= _dirtyBottom) return 0;
+  _flushing = true;
+  const uint32_t pushedBefore = _pixelsPushed;
+  ShadowFramebufferSpan_t spans[SHADOW_FRAMEBUFFER_MAX_ROW_SPANS];
+
+  // rows changed in the same columns are pushed together as one region, since that's one window on the display
+  int32_t pendingX = 0;
+  int32_t pendingY = 0;
+  int32_t pendingW = 0;
+  int32_t pendingH = 0;
+  for (int32_t y = _dirtyTop; y < _dirtyBottom; y++) {
+    uint8_t spanCount = 1;
+    if (_resend) {
+      spans[0] = {0, _width};
+    } else {
+      spanCount = diffRow(_frame + y * _width, _sent + y * _width, _width, spans, SHADOW_FRAMEBUFFER_MAX_ROW_SPANS);
+    }
+    if (spanCount == 1 && pendingH > 0 && spans[0].x == pendingX && spans[0].w == pendingW) {
+      pendingH++;
+      continue;
+    }
+    push(display, pendingX, pendingY, pendingW, pendingH);
+    pendingH = 0;
+    if (spanCount == 1) {
+      pendingX = spans[0].x;
+      pendingY = y;
+      pendingW = spans[0].w;
+      pendingH = 1;
+    } else {
+      for (uint8_t i = 0; i < spanCount; i++) push(display, spans[i].x, y, spans[i].w, 1);
+    }
+  }
+  push(display, pendingX, pendingY, pendingW, pendingH);
+
+  memcpy(_sent + _dirtyTop * _width, _frame + _dirtyTop * _width,
+         (_dirtyBottom - _dirtyTop) * _width * sizeof(uint16_t));
+  _pixelsSkipped += (_dirtyBottom - _dirtyTop) * _width - (_pixelsPushed - pushedBefore);
+  _dirtyTop = _dirtyBottom = 0;
+  _resend = false;
+  _flushes++;
+  _flushing = false;
+  return _pixelsPushed - pushedBefore;
+}
+
+uint8_t ShadowFramebuffer::diffRow(const uint16_t *frame, const uint16_t *sent, int32_t width,
+                                   ShadowFramebufferSpan_t *spans, uint8_t maxSpans) {
+  if (memcmp(frame, sent, width * sizeof(uint16_t)) == 0) return 0;
+  uint8_t spanCount = 0;
+  int32_t x = 0;
+  while (x < width) {
+    if (frame[x] == sent[x]) {
+      x++;
+      continue;
+    }
+    const int32_t start = x;
+    int32_t end = ++x;
+    for (; x < width && x - end < SHADOW_FRAMEBUFFER_MERGE_GAP; x++) {
+      if (frame[x] != sent[x]) end = x + 1;
+    }
+    if (spanCount == maxSpans) {
+      spans[spanCount - 1].w = end - spans[spanCount - 1].x;
+    } else {
+      spans[spanCount++] = {start, end - start};
+    }
+  }
+  return spanCount;
+}
+
+void ShadowFramebuffer::dirty(int32_t top, int32_t bottom) {
+  if (top >= bottom) return;
+  if (_dirtyTop >= _dirtyBottom) {
+    _dirtyTop = top;
+    _dirtyBottom = bottom;
+    return;
+  }
+  if (top < _dirtyTop) _dirtyTop = top;
+  if (bottom > _dirtyBottom) _dirtyBottom = bottom;
+}
+
+void ShadowFramebuffer::push(DisplayBackend &display, int32_t x, int32_t y, int32_t w, int32_t h) {
+  if (w <= 0 || h <= 0) return;
+  display.pushRegion(x, y, w, h, _frame + y * _width + x, _width);
+  _pixelsPushed += w * h;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include "DisplayBackend.h"
+
+// a few matching pixels cost less to push again than setting up another window on the display
+#define SHADOW_FRAMEBUFFER_MERGE_GAP 8
+#define SHADOW_FRAMEBUFFER_MAX_ROW_SPANS 8
+
+typedef struct {
+  int32_t x;
+  int32_t w;
+} ShadowFramebufferSpan_t;
+
+// The whole screen held in memory, with a copy of what was last sent to the display. Drawing only touches memory, and
+// flushing compares each row drawn on since the last flush against what was sent, pushing just the spans that changed.
+// Pixels are kept byte swapped, like everything else pushed through a DisplayBackend.
+class ShadowFramebuffer : public DisplayBackend {
+ public:
+  // both buffers are width * height pixels, what's on the display to begin with isn't known so it's all sent once
+  void begin(uint16_t *frame, uint16_t *sent, int32_t width, int32_t height);
+  bool active() { return _frame != nullptr; }
+  // false while flushing, so a display drawing into this can tell its own pushes apart from the flush's
+  bool drawing() { return _frame != nullptr && !_flushing; }
+  // rotating keeps the same number of pixels, the frame is cleared to black and sent again in full
+  void resize(int32_t width, int32_t height);
+
+  void pushRegion(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *pixels, int32_t stride) override;
+  void fillRegion(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) override;
+  void drawPixel(int32_t x, int32_t y, uint32_t color);
+
+  // push whatever changed since the last flush, returns how many pixels went out
+  uint32_t flush(DisplayBackend &display);
+
+  // the spans of a row that differ from what was sent, nearby spans are joined and past the limit the last one takes
+  // in the rest of the row's changes
+  static uint8_t diffRow(const uint16_t *frame, const uint16_t *sent, int32_t width, ShadowFramebufferSpan_t *spans,
+                         uint8_t maxSpans);
+
+  const uint16_t *frame() { return _frame; }
+  uint32_t flushes() { return _flushes; }
+  uint32_t pixelsPushed() { return _pixelsPushed; }
+  uint32_t pixelsSkipped() { return _pixelsSkipped; }
+
+ protected:
+  void dirty(int32_t top, int32_t bottom);
+  void push(DisplayBackend &display, int32_t x, int32_t y, int32_t w, int32_t h);
+
+  uint16_t *_frame = nullptr;
+  uint16_t *_sent = nullptr;
+  int32_t _width = 0;
+  int32_t _height = 0;
+  // rows from top up to but not including bottom have been drawn on since the last flush
+  int32_t _dirtyTop = 0;
+  int32_t _dirtyBottom = 0;
+  bool _resend = false;
+  bool _flushing = false;
+  uint32_t _flushes = 0;
+  uint32_t _pixelsPushed = 0;
+  uint32_t _pixelsSkipped = 0;
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#define SPOTIFY_ID_SIZE 22
+
+// A Spotify base62 id ("4uLU6hMCjMI75M1A2tKUQC") is a 128-bit number, stored here in 16 bytes instead of 23
+class SpotifyId {
+ public:
+  constexpr SpotifyId() : high(0), low(0) {}
+  constexpr SpotifyId(uint64_t high, uint64_t low) : high(high), low(low) {}
+
+  // parse exactly SPOTIFY_ID_SIZE base62 characters, or return an empty id if they aren't valid
+  static SpotifyId decode(const char *base62) {
+    if (!base62) return SpotifyId();
+    uint32_t words[4] = {0, 0, 0, 0};
+    for (auto i = 0; i < SPOTIFY_ID_SIZE; i++) {
+      const int digit = digitValue(base62[i]);
+      if (digit < 0) return SpotifyId();
+      uint32_t carry = digit;
+      for (auto w = 3; w >= 0; w--) {
+        const uint64_t value = (uint64_t)words[w] * 62 + carry;
+        words[w] = (uint32_t)value;
+        carry = value >> 32;
+      }
+      if (carry) return SpotifyId();
+    }
+    return SpotifyId((uint64_t)words[0] << 32 | words[1], (uint64_t)words[2] << 32 | words[3]);
+  }
+
+  // write the base62 form, base62 must have room for SPOTIFY_ID_SIZE + 1 characters
+  void encode(char *base62) const {
+    uint32_t words[4] = {(uint32_t)(high >> 32), (uint32_t)high, (uint32_t)(low >> 32), (uint32_t)low};
+    for (auto i = SPOTIFY_ID_SIZE - 1; i >= 0; i--) {
+      uint32_t remainder = 0;
+      for (auto w = 0; w < 4; w++) {
+        const uint64_t value = (uint64_t)remainder << 32 | words[w];
+        words[w] = value / 62;
+        remainder = value % 62;
+      }
+      base62[i] = alphabet()[remainder];
+    }
+    base62[SPOTIFY_ID_SIZE] = '\0';
+  }
+
+  // murmur3 over the four 32-bit words, must match id_hash in load_genres.rb
+  uint32_t hash(uint32_t seed = 0) const {
+    const uint32_t words[4] = {(uint32_t)(high >> 32), (uint32_t)high, (uint32_t)(low >> 32), (uint32_t)low};
+    uint32_t h = seed;
+    for (auto w : words) {
+      w *= 0xcc9e2d51;
+      w = (w << 15) | (w >> 17);
+      w *= 0x1b873593;
+      h ^= w;
+      h = (h << 13) | (h >> 19);
+      h = h * 5 + 0xe6546b64;
+    }
+    h ^= 16;
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35;
+    return h ^ (h >> 16);
+  }
+
+  bool isEmpty() const { return high == 0 && low == 0; }
+  void clear() { high = low = 0; }
+
+  bool operator==(const SpotifyId &other) const { return high == other.high && low == other.low; }
+  bool operator!=(const SpotifyId &other) const { return !(*this == other); }
+
+  uint64_t high;
+  uint64_t low;
+
+ private:
+  static const char *alphabet() { return "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ"; }
+
+  static int digitValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'Z') return c - 'A' + 36;
+    return -1;
+  }
+};
+
+static_assert(sizeof(SpotifyId) == 16, "SpotifyId should be 16 bytes");
@@ -0,0 +1,107 @@
+#include "SpriteArena.h"
+
+bool SpriteArena::reserve(GlyphSprite &sprite, int16_t width, int16_t height) {
+  SpriteArenaSlot_t *slot = slotFor(sprite);
+  if (!slot) {
+    log_e("no sprite arena slots left");
+    return false;
+  }
+  if (slot->width >= width && slot->height >= height) return true;
+
+  width = max(width, slot->width);
+  height = max(height, slot->height);
+  // 4 bit sprites are pushed two pixels to a byte
+  if (sprite.paletted()) width = (width + 1) & ~1;
+  sprite.deleteSprite();
+  if (!sprite.createSprite(width, height)) {
+    log_e("unable to reserve %dx%d sprite", width, height);
+    slot->width = slot->height = 0;
+    return false;
+  }
+  slot->width = width;
+  slot->height = height;
+  _allocations++;
+  _allocatedBytes += width * height * sprite.getColorDepth() / 8;
+  return true;
+}
+
+bool SpriteArena::borrow(GlyphSprite &sprite, int16_t width, int16_t height) {
+  SpriteArenaSlot_t *slot = slotFor(sprite);
+  if (!slot || slot->borrowed) {
+    log_e("sprite is already borrowed");
+    return false;
+  }
+  _borrows++;
+  slot->temporary = width > slot->width || height > slot->height;
+  if (slot->temporary) {
+    // the reserved buffer has to go so there's only ever one per sprite, it's made again when this is given back
+    log_e("%dx%d sprite is larger than reserved %dx%d", width, height, slot->width, slot->height);
+    const int16_t reservedWidth = slot->width;
+    const int16_t reservedHeight = slot->height;
+    sprite.deleteSprite();
+    slot->width = slot->height = 0;
+    if (!sprite.createSprite(sprite.paletted() ? (width + 1) & ~1 : width, height)) {
+      slot->temporary = false;
+      if (reservedWidth > 0 && reservedHeight > 0) reserve(sprite, reservedWidth, reservedHeight);
+      return false;
+    }
+    slot->width = reservedWidth;
+    slot->height = reservedHeight;
+    _allocations++;
+    _allocatedBytes += width * height * sprite.getColorDepth() / 8;
+  }
+  slot->borrowed = true;
+  slot->borrowedWidth = width;
+  slot->borrowedHeight = height;
+  clear(sprite);
+  return true;
+}
+
+void SpriteArena::clear(GlyphSprite &sprite, uint32_t color) {
+  SpriteArenaSlot_t *slot = slotFor(sprite);
+  if (!slot || !slot->borrowed) return;
+  // a 4 bit sprite only has shades between its text colors, and 0 is the background
+  sprite.fillRect(0, 0, slot->borrowedWidth, slot->borrowedHeight, sprite.paletted() ? 0 : color);
+}
+
+void SpriteArena::push(GlyphSprite &sprite, int32_t x, int32_t y) {
+  SpriteArenaSlot_t *slot = slotFor(sprite);
+  if (!slot || !slot->borrowed) return;
+  // pushSprite would go around the display's queue and shadow framebuffer
+  if (!_display) {
+    log_e("no display to push sprites to");
+  } else if (sprite.paletted()) {
+    sprite.pushPalette(*_display, x, y, 0, slot->borrowedWidth, slot->borrowedHeight);
+  } else if (sprite.getColorDepth() == 16) {
+    _display->pushRegion(x, y, slot->borrowedWidth, slot->borrowedHeight, (uint16_t *)sprite.getPointer(),
+                         sprite.width());
+  } else {
+    log_e("unable to push %d bit sprite", sprite.getColorDepth());
+  }
+}
+
+void SpriteArena::giveBack(GlyphSprite &sprite) {
+  SpriteArenaSlot_t *slot = slotFor(sprite);
+  if (!slot || !slot->borrowed) return;
+  slot->borrowed = false;
+  if (slot->temporary) {
+    slot->temporary = false;
+    const int16_t width = slot->width;
+    const int16_t height = slot->height;
+    sprite.deleteSprite();
+    slot->width = slot->height = 0;
+    if (width > 0 && height > 0) reserve(sprite, width, height);
+  }
+}
+
+SpriteArenaSlot_t *SpriteArena::slotFor(GlyphSprite &sprite) {
+  SpriteArenaSlot_t *empty = nullptr;
+  for (auto &slot : _slots) {
+    if (slot.sprite == &sprite) return &slot;
+    if (!empty && !slot.sprite) empty = &slot;
+  }
+  if (empty) empty->sprite = &sprite;
+  return empty;
+}
+
+SpriteArena spriteArena;
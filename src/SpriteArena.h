@@ -0,0 +1,49 @@
+#pragma once
+
+#include "DisplayBackend.h"
+#include "GlyphSprite.h"
+
+#define SPRITE_ARENA_SLOTS 4
+
+typedef struct {
+  GlyphSprite *sprite = nullptr;
+  int16_t width = 0;
+  int16_t height = 0;
+  int16_t borrowedWidth = 0;
+  int16_t borrowedHeight = 0;
+  bool borrowed = false;
+  bool temporary = false;
+} SpriteArenaSlot_t;
+
+// Sprites created once at the largest size anything draws with them, then borrowed for each draw, so rendering doesn't
+// allocate and free sprite buffers from the heap TLS connections need. Draws use the top left corner of the sprite.
+class SpriteArena {
+ public:
+  // create the sprite's buffer, during setup before anything borrows it
+  bool reserve(GlyphSprite &sprite, int16_t width, int16_t height);
+  // where borrowed sprites are pushed, nothing is pushed until it's set
+  void setDisplay(DisplayBackend *display) { _display = display; }
+
+  // clear a width by height area of the sprite to draw into, it's created for just this draw if it wasn't reserved
+  // big enough, nothing can be drawn into it if that fails
+  bool borrow(GlyphSprite &sprite, int16_t width, int16_t height) __attribute__((warn_unused_result));
+  void clear(GlyphSprite &sprite, uint32_t color = TFT_BLACK);
+  void push(GlyphSprite &sprite, int32_t x, int32_t y);
+  void giveBack(GlyphSprite &sprite);
+
+  // sprite buffers created, which stops going up after setup unless a draw doesn't fit in its reserved sprite
+  uint32_t allocations() { return _allocations; }
+  uint32_t allocatedBytes() { return _allocatedBytes; }
+  uint32_t borrows() { return _borrows; }
+
+ protected:
+  SpriteArenaSlot_t *slotFor(GlyphSprite &sprite);
+
+  DisplayBackend *_display = nullptr;
+  SpriteArenaSlot_t _slots[SPRITE_ARENA_SLOTS];
+  uint32_t _allocations = 0;
+  uint32_t _allocatedBytes = 0;
+  uint32_t _borrows = 0;
+};
+
+extern SpriteArena spriteArena;
@@ -0,0 +1,166 @@
+#include "TextLineCache.h"
+
+#include <esp_heap_caps.h>
+
+bool TextLineCache::setup(uint16_t lineHeight) {
+  const size_t cellSize = TEXT_LINE_CACHE_CELL_WIDTH * lineHeight * sizeof(uint16_t);
+  const uint16_t cellCount = TEXT_LINE_CACHE_BYTES / cellSize;
+#ifdef BOARD_HAS_PSRAM
+  _pixels = (uint16_t *)ps_malloc(cellCount * cellSize);
+#else
+  if (heap_caps_get_largest_free_block(MALLOC_CAP_8BIT) < cellCount * cellSize + TEXT_LINE_CACHE_HEAP_RESERVE) {
+    log_i("not enough heap for a %u byte text line cache", cellCount * cellSize);
+    return false;
+  }
+  _pixels = (uint16_t *)malloc(cellCount * cellSize);
+#endif
+  _freeCells = (uint16_t *)malloc(cellCount * sizeof(uint16_t));
+  if (!_pixels || !_freeCells) {
+    log_e("no memory for %u byte text line cache", cellCount * cellSize);
+    free(_pixels);
+    free(_freeCells);
+    _pixels = nullptr;
+    _freeCells = nullptr;
+    return false;
+  }
+  _lineHeight = lineHeight;
+  _cellCount = _freeCount = cellCount;
+  for (uint16_t i = 0; i < cellCount; i++) _freeCells[i] = i;
+  return true;
+}
+
+TextLineKey_t TextLineCache::key(const char *text, uint32_t fgColor, uint32_t bgColor, uint16_t maxWidth,
+                                 uint8_t maxLines) {
+  TextLineKey_t key;
+  // FNV-1a
+  key.hash = 2166136261u;
+  for (const char *c = text; *c != '\0'; c++) {
+    key.hash = (key.hash ^ (uint8_t)*c) * 16777619u;
+    key.length++;
+  }
+  key.fgColor = fgColor;
+  key.bgColor = bgColor;
+  key.maxWidth = maxWidth;
+  key.maxLines = maxLines;
+  return key;
+}
+
+uint8_t TextLineCache::draw(DisplayBackend &display, const TextLineKey_t &key, int32_t x, int32_t y) {
+  if (!cached(key)) {
+    _misses++;
+    return 0;
+  }
+  _hits++;
+
+  const uint8_t lineCount = find(key, 0)->lineCount;
+  for (uint8_t line = 0; line < lineCount; line++) {
+    TextLineCacheEntry_t *entry = find(key, line);
+    const int32_t lineY = y + line * _lineHeight;
+    const uint16_t inkEnd = entry->inkX + entry->inkWidth;
+    entry->lastUsed = ++_clock;
+    display.fillRegion(x, lineY, entry->inkX, _lineHeight, key.bgColor);
+    for (uint8_t i = 0; i < entry->cellCount; i++) {
+      const uint16_t cellX = entry->inkX + i * TEXT_LINE_CACHE_CELL_WIDTH;
+      const uint16_t width = min(TEXT_LINE_CACHE_CELL_WIDTH, inkEnd - cellX);
+      const uint16_t *cell = _pixels + entry->cells[i] * TEXT_LINE_CACHE_CELL_WIDTH * _lineHeight;
+      display.pushRegion(x + cellX, lineY, width, _lineHeight, cell, TEXT_LINE_CACHE_CELL_WIDTH);
+    }
+    display.fillRegion(x + inkEnd, lineY, key.maxWidth - inkEnd, _lineHeight, key.bgColor);
+  }
+  return lineCount;
+}
+
+bool TextLineCache::cached(const TextLineKey_t &key) {
+  TextLineCacheEntry_t *first = find(key, 0);
+  if (!first || first->lineCount == 0) return false;
+  for (uint8_t line = 1; line < first->lineCount; line++) {
+    if (!find(key, line)) return false;
+  }
+  return true;
+}
+
+void TextLineCache::store(const TextLineKey_t &key, uint8_t line, const uint16_t *pixels, uint16_t stride) {
+  if (!_pixels || !pixels) return;
+
+  // only the columns with something other than background in them are kept
+  const uint16_t bg = (uint16_t)((key.bgColor >> 8) | (key.bgColor << 8));
+  int16_t inkStart = -1;
+  int16_t inkEnd = -1;
+  for (uint16_t x = 0; x < key.maxWidth; x++) {
+    for (uint16_t y = 0; y < _lineHeight; y++) {
+      if (pixels[y * stride + x] == bg) continue;
+      if (inkStart < 0) inkStart = x;
+      inkEnd = x + 1;
+      break;
+    }
+  }
+  if (inkStart < 0) inkStart = inkEnd = 0;
+  const uint8_t cellCount = (inkEnd - inkStart + TEXT_LINE_CACHE_CELL_WIDTH - 1) / TEXT_LINE_CACHE_CELL_WIDTH;
+  if (cellCount > TEXT_LINE_CACHE_MAX_LINE_CELLS || cellCount > _cellCount) return;
+
+  evict(find(key, line));
+  while (_freeCount < cellCount) evict(leastRecentlyUsed());
+  TextLineCacheEntry_t *entry = nullptr;
+  for (auto &candidate : _entries) {
+    if (candidate.lastUsed == 0) {
+      entry = &candidate;
+      break;
+    }
+  }
+  if (!entry) {
+    entry = leastRecentlyUsed();
+    evict(entry);
+  }
+
+  entry->key = key;
+  entry->line = line;
+  entry->lineCount = 0;
+  entry->inkX = inkStart;
+  entry->inkWidth = inkEnd - inkStart;
+  entry->cellCount = cellCount;
+  entry->lastUsed = ++_clock;
+  for (uint8_t i = 0; i < cellCount; i++) {
+    entry->cells[i] = _freeCells[--_freeCount];
+    const uint16_t cellX = inkStart + i * TEXT_LINE_CACHE_CELL_WIDTH;
+    const uint16_t width = min(TEXT_LINE_CACHE_CELL_WIDTH, inkEnd - cellX);
+    uint16_t *cell = _pixels + entry->cells[i] * TEXT_LINE_CACHE_CELL_WIDTH * _lineHeight;
+    for (uint16_t y = 0; y < _lineHeight; y++) {
+      memcpy(cell + y * TEXT_LINE_CACHE_CELL_WIDTH, pixels + y * stride + cellX, width * sizeof(uint16_t));
+    }
+  }
+}
+
+void TextLineCache::complete(const TextLineKey_t &key, uint8_t lineCount) {
+  TextLineCacheEntry_t *first = find(key, 0);
+  if (first) first->lineCount = lineCount;
+}
+
+bool TextLineCache::sameKey(const TextLineKey_t &a, const TextLineKey_t &b) {
+  return a.hash == b.hash && a.length == b.length && a.maxWidth == b.maxWidth && a.maxLines == b.maxLines &&
+         a.fgColor == b.fgColor && a.bgColor == b.bgColor;
+}
+
+TextLineCacheEntry_t *TextLineCache::find(const TextLineKey_t &key, uint8_t line) {
+  for (auto &entry : _entries) {
+    if (entry.lastUsed != 0 && entry.line == line && sameKey(entry.key, key)) return &entry;
+  }
+  return nullptr;
+}
+
+void TextLineCache::evict(TextLineCacheEntry_t *entry) {
+  if (!entry || entry->lastUsed == 0) return;
+  for (uint8_t i = 0; i < entry->cellCount; i++) _freeCells[_freeCount++] = entry->cells[i];
+  entry->cellCount = 0;
+  entry->lastUsed = 0;
+  _evictions++;
+}
+
+TextLineCacheEntry_t *TextLineCache::leastRecentlyUsed() {
+  TextLineCacheEntry_t *oldest = nullptr;
+  for (auto &entry : _entries) {
+    if (entry.lastUsed != 0 && (!oldest || entry.lastUsed < oldest->lastUsed)) oldest = &entry;
+  }
+  return oldest;
+}
+
+TextLineCache textLineCache;
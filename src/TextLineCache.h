@@ -0,0 +1,87 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "DisplayBackend.h"
+
+// lines are kept in columns of cells this wide, so a line only takes up as many as its text covers
+#define TEXT_LINE_CACHE_CELL_WIDTH 32
+#define TEXT_LINE_CACHE_MAX_LINE_CELLS 10
+
+// plenty of menus worth of lines with PSRAM, without it a few cells for the line on screen, and only if the heap TLS
+// connections need would still have TEXT_LINE_CACHE_HEAP_RESERVE left
+#ifdef BOARD_HAS_PSRAM
+#define TEXT_LINE_CACHE_BYTES (512 * 1024)
+#define TEXT_LINE_CACHE_ENTRIES 160
+#else
+#define TEXT_LINE_CACHE_BYTES (8 * 1024)
+#define TEXT_LINE_CACHE_ENTRIES 8
+#define TEXT_LINE_CACHE_HEAP_RESERVE (48 * 1024)
+#endif
+
+// everything that changes how drawCenteredText renders a text
+typedef struct {
+  uint32_t hash = 0;
+  uint16_t length = 0;
+  uint16_t maxWidth = 0;
+  uint8_t maxLines = 0;
+  uint32_t fgColor = 0;
+  uint32_t bgColor = 0;
+} TextLineKey_t;
+
+typedef struct {
+  TextLineKey_t key;
+  uint8_t line = 0;
+  // set on the first line once every line of the text is stored
+  uint8_t lineCount = 0;
+  uint16_t inkX = 0;
+  uint16_t inkWidth = 0;
+  uint8_t cellCount = 0;
+  uint16_t cells[TEXT_LINE_CACHE_MAX_LINE_CELLS];
+  uint32_t lastUsed = 0;
+} TextLineCacheEntry_t;
+
+// Lines of text already rendered by drawCenteredText, so showing one again is pushing the columns its text covers and
+// filling in the background around them. Entries are kept in RGB565 in the byte order sprites push to the display.
+class TextLineCache {
+ public:
+  // cells are as tall as a line of text, so this waits until the font is loaded
+  bool setup(uint16_t lineHeight);
+  // room for this many lines of the widest text at once, none without memory for the cache
+  bool fits(uint8_t lines) { return _cellCount >= lines * TEXT_LINE_CACHE_MAX_LINE_CELLS; }
+
+  static TextLineKey_t key(const char *text, uint32_t fgColor, uint32_t bgColor, uint16_t maxWidth, uint8_t maxLines);
+
+  // push every line of a text, returns how many lines it took or 0 if it isn't all cached
+  uint8_t draw(DisplayBackend &display, const TextLineKey_t &key, int32_t x, int32_t y);
+  bool cached(const TextLineKey_t &key);
+  // copy the columns of a rendered line that aren't background in, evicting the least recently used lines for room
+  void store(const TextLineKey_t &key, uint8_t line, const uint16_t *pixels, uint16_t stride);
+  // once every line of a text has been stored
+  void complete(const TextLineKey_t &key, uint8_t lineCount);
+
+  uint32_t hits() { return _hits; }
+  uint32_t misses() { return _misses; }
+  uint32_t evictions() { return _evictions; }
+  uint16_t cellsUsed() { return _cellCount - _freeCount; }
+  uint16_t cellCount() { return _cellCount; }
+
+ protected:
+  static bool sameKey(const TextLineKey_t &a, const TextLineKey_t &b);
+  TextLineCacheEntry_t *find(const TextLineKey_t &key, uint8_t line);
+  void evict(TextLineCacheEntry_t *entry);
+  TextLineCacheEntry_t *leastRecentlyUsed();
+
+  uint16_t *_pixels = nullptr;
+  uint16_t _lineHeight = 0;
+  uint16_t _cellCount = 0;
+  uint16_t *_freeCells = nullptr;
+  uint16_t _freeCount = 0;
+  TextLineCacheEntry_t _entries[TEXT_LINE_CACHE_ENTRIES];
+  uint32_t _clock = 0;
+  uint32_t _hits = 0;
+  uint32_t _misses = 0;
+  uint32_t _evictions = 0;
+};
+
+extern TextLineCache textLineCache;
@@ -0,0 +1,234 @@
+#include "TftDisplay.h"
+
+bool TftDisplay::beginPipeline() {
+  if (_flushTask) return true;
+  _queuedRegions = xQueueCreate(TFT_DISPLAY_BUFFERS, sizeof(TftDisplayRegion_t));
+  _freeBuffers = xQueueCreate(TFT_DISPLAY_BUFFERS, sizeof(uint16_t *));
+  _idleLock = xSemaphoreCreateMutex();
+  if (!_queuedRegions || !_freeBuffers || !_idleLock) {
+    log_e("unable to create display queues, pushing regions directly");
+    endPipeline();
+    return false;
+  }
+  for (auto i = 0; i < TFT_DISPLAY_BUFFERS; i++) {
+    _buffers[i] = (uint16_t *)malloc(TFT_DISPLAY_BUFFER_PIXELS * sizeof(uint16_t));
+    if (!_buffers[i]) {
+      log_e("no memory for display buffers, pushing regions directly");
+      endPipeline();
+      return false;
+    }
+    xQueueSend(_freeBuffers, &_buffers[i], 0);
+  }
+  // above the JPEG decoder on the same core, a region waiting to be pushed holds up composing
+  if (xTaskCreatePinnedToCore(flushLoop, "tftFlush", TFT_DISPLAY_FLUSH_STACK, this, 2, &_flushTask, TFT_DISPLAY_FLUSH_CORE) != pdPASS) {
+    _flushTask = nullptr;
+    log_e("unable to start display flush task, pushing regions directly");
+    endPipeline();
+    return false;
+  }
+  return true;
+}
+
+void TftDisplay::endPipeline() {
+  if (_queuedRegions) vQueueDelete(_queuedRegions);
+  if (_freeBuffers) vQueueDelete(_freeBuffers);
+  if (_idleLock) vSemaphoreDelete(_idleLock);
+  _queuedRegions = nullptr;
+  _freeBuffers = nullptr;
+  _idleLock = nullptr;
+  for (auto &buffer : _buffers) {
+    free(buffer);
+    buffer = nullptr;
+  }
+}
+
+bool TftDisplay::beginShadow() {
+  if (_shadow.active()) return true;
+  const size_t size = width() * height() * sizeof(uint16_t);
+  auto frame = (uint16_t *)ps_malloc(size);
+  auto sent = (uint16_t *)ps_malloc(size);
+  if (!frame || !sent) {
+    log_e("no memory for %u byte shadow framebuffers, drawing directly", size * 2);
+    free(frame);
+    free(sent);
+    return false;
+  }
+  waitIdle();
+  _shadow.begin(frame, sent, width(), height());
+  return true;
+}
+
+void TftDisplay::flushShadow() {
+  // the flush pushes through pushRegion, which goes to the display while the shadow isn't drawing
+  if (_shadow.active()) _shadow.flush(*this);
+}
+
+void TftDisplay::pushRegion(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *pixels, int32_t stride) {
+  if (w <= 0 || h <= 0) return;
+  if (_shadow.drawing()) {
+    _shadow.pushRegion(x, y, w, h, pixels, stride);
+    return;
+  }
+  if (!_flushTask || w > TFT_DISPLAY_BUFFER_PIXELS) {
+    waitIdle();
+    const unsigned long start = micros();
+    if (stride == w) {
+      push({x, y, w, h, (uint16_t *)pixels});
+    } else {
+      for (int32_t row = 0; row < h; row++) push({x, y + row, w, 1, (uint16_t *)pixels + row * stride});
+    }
+    _flushMicros += micros() - start;
+    return;
+  }
+
+  // as many whole rows as fit in a buffer at a time
+  const int32_t rowsPerBuffer = TFT_DISPLAY_BUFFER_PIXELS / w;
+  for (int32_t row = 0; row < h; row += rowsPerBuffer) {
+    TftDisplayRegion_t region = {x, y + row, w, min(rowsPerBuffer, h - row), nullptr};
+    const unsigned long start = micros();
+    xQueueReceive(_freeBuffers, &region.pixels, portMAX_DELAY);
+    _waitMicros += micros() - start;
+    for (int32_t i = 0; i < region.h; i++) {
+      memcpy(region.pixels + i * w, pixels + (row + i) * stride, w * sizeof(uint16_t));
+    }
+    xQueueSend(_queuedRegions, &region, portMAX_DELAY);
+  }
+}
+
+void TftDisplay::fillRegion(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) {
+  if (w <= 0 || h <= 0) return;
+  if (_shadow.drawing()) {
+    _shadow.fillRegion(x, y, w, h, color);
+    return;
+  }
+  TftDisplayRegion_t region = {x, y, w, h, nullptr, true, color};
+  if (!_flushTask) {
+    const unsigned long start = micros();
+    push(region);
+    _flushMicros += micros() - start;
+    return;
+  }
+  const unsigned long start = micros();
+  xQueueReceive(_freeBuffers, &region.pixels, portMAX_DELAY);
+  _waitMicros += micros() - start;
+  xQueueSend(_queuedRegions, &region, portMAX_DELAY);
+}
+
+void TftDisplay::waitIdle() {
+  if (!_flushTask || uxQueueMessagesWaiting(_freeBuffers) == TFT_DISPLAY_BUFFERS) return;
+  // every buffer back in the free queue means nothing's left to push
+  const unsigned long start = micros();
+  uint16_t *buffers[TFT_DISPLAY_BUFFERS];
+  xSemaphoreTake(_idleLock, portMAX_DELAY);
+  for (auto i = 0; i < TFT_DISPLAY_BUFFERS; i++) xQueueReceive(_freeBuffers, &buffers[i], portMAX_DELAY);
+  for (auto i = 0; i < TFT_DISPLAY_BUFFERS; i++) xQueueSend(_freeBuffers, &buffers[i], 0);
+  xSemaphoreGive(_idleLock);
+  _waitMicros += micros() - start;
+}
+
+void TftDisplay::push(const TftDisplayRegion_t &region) {
+  if (region.fill) {
+    TFT_eSPI::fillRect(region.x, region.y, region.w, region.h, region.color);
+    return;
+  }
+  const bool swapBytes = getSwapBytes();
+  setSwapBytes(false);
+  pushImage(region.x, region.y, region.w, region.h, region.pixels);
+  setSwapBytes(swapBytes);
+}
+
+void TftDisplay::flushLoop(void *params) {
+  auto display = (TftDisplay *)params;
+  TftDisplayRegion_t region;
+  for (;;) {
+    if (xQueueReceive(display->_queuedRegions, &region, portMAX_DELAY) != pdTRUE) continue;
+    const unsigned long start = micros();
+    display->push(region);
+    display->_flushMicros += micros() - start;
+    xQueueSend(display->_freeBuffers, &region.pixels, portMAX_DELAY);
+  }
+}
+
+void TftDisplay::drawPixel(int32_t x, int32_t y, uint32_t color) {
+  if (_shadow.drawing()) {
+    _shadow.drawPixel(x, y, color);
+    return;
+  }
+  waitIdle();
+  TFT_eSPI::drawPixel(x, y, color);
+}
+
+void TftDisplay::drawLine(int32_t xs, int32_t ys, int32_t xe, int32_t ye, uint32_t color) {
+  if (_shadow.drawing()) {
+    shadowLine(xs, ys, xe, ye, color);
+    return;
+  }
+  waitIdle();
+  TFT_eSPI::drawLine(xs, ys, xe, ye, color);
+}
+
+void TftDisplay::drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color) {
+  if (_shadow.drawing()) {
+    _shadow.fillRegion(x, y, 1, h, color);
+    return;
+  }
+  waitIdle();
+  TFT_eSPI::drawFastVLine(x, y, h, color);
+}
+
+void TftDisplay::drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color) {
+  if (_shadow.drawing()) {
+    _shadow.fillRegion(x, y, w, 1, color);
+    return;
+  }
+  waitIdle();
+  TFT_eSPI::drawFastHLine(x, y, w, color);
+}
+
+void TftDisplay::fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) {
+  if (_shadow.drawing()) {
+    _shadow.fillRegion(x, y, w, h, color);
+    return;
+  }
+  waitIdle();
+  TFT_eSPI::fillRect(x, y, w, h, color);
+}
+
+void TftDisplay::drawGlyph(uint16_t code) {
+  waitIdle();
+  TFT_eSPI::drawGlyph(code);
+}
+
+void TftDisplay::setDisplayRotation(uint8_t rotation) {
+  waitIdle();
+  TFT_eSPI::setRotation(rotation);
+  _shadow.resize(width(), height());
+}
+
+void TftDisplay::sendCommand(uint8_t command) {
+  // whatever was drawn should be showing before the display is turned off or put to sleep
+  flushShadow();
+  waitIdle();
+  TFT_eSPI::writecommand(command);
+}
+
+void TftDisplay::shadowLine(int32_t xs, int32_t ys, int32_t xe, int32_t ye, uint32_t color) {
+  const int32_t dx = abs(xe - xs);
+  const int32_t dy = -abs(ye - ys);
+  const int32_t stepX = xs < xe ? 1 : -1;
+  const int32_t stepY = ys < ye ? 1 : -1;
+  int32_t error = dx + dy;
+  for (;;) {
+    _shadow.drawPixel(xs, ys, color);
+    if (xs == xe && ys == ye) return;
+    const int32_t error2 = error * 2;
+    if (error2 >= dy) {
+      error += dy;
+      xs += stepX;
+    }
+    if (error2 <= dx) {
+      error += dx;
+      ys += stepY;
+    }
+  }
+}
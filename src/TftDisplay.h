@@ -0,0 +1,82 @@
+#pragma once
+
+#include <TFT_eSPI.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#include "DisplayBackend.h"
+#include "ShadowFramebuffer.h"
+
+// two buffers, so one region is copied in while the other is being pushed
+#define TFT_DISPLAY_BUFFERS 2
+#define TFT_DISPLAY_BUFFER_PIXELS 2048
+#define TFT_DISPLAY_FLUSH_CORE 0
+#define TFT_DISPLAY_FLUSH_STACK 2048
+
+typedef struct {
+  int32_t x;
+  int32_t y;
+  int32_t w;
+  int32_t h;
+  uint16_t *pixels;
+  // filled with a color instead, pixels is only holding a buffer so waiting for the buffers waits for this too
+  bool fill;
+  uint32_t color;
+} TftDisplayRegion_t;
+
+// The TFT, which can push composed regions from a task on the other core. Regions are copied into a free buffer and
+// queued, so the next one can be composed while the last is still going out over SPI or the parallel bus. Anything
+// that draws to the TFT directly waits for queued regions first, so nothing else uses the bus while they're pushed.
+// With enough memory for a shadow framebuffer, drawing goes there instead and flushShadow sends only what changed.
+// Only one task should draw, the loop, since regions from two would be interleaved on the display.
+class TftDisplay : public TFT_eSPI, public DisplayBackend {
+ public:
+  TftDisplay(int16_t width, int16_t height) : TFT_eSPI(width, height) {}
+
+  // start pushing regions from a task, or push them as they come if that can't be set up
+  bool beginPipeline();
+  bool pipelined() { return _flushTask != nullptr; }
+  // draw into a copy of the screen in PSRAM from here on, nothing reaches the display until it's flushed
+  bool beginShadow();
+  void flushShadow();
+  ShadowFramebuffer &shadow() { return _shadow; }
+
+  void pushRegion(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *pixels, int32_t stride) override;
+  void fillRegion(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) override;
+  void waitIdle() override;
+  uint32_t flushMicros() override { return _flushMicros; }
+  uint32_t waitMicros() override { return _waitMicros; }
+  // the least stack the flush task has had left, in bytes
+  uint32_t flushStackFree() { return _flushTask ? uxTaskGetStackHighWaterMark(_flushTask) : 0; }
+
+  void drawPixel(int32_t x, int32_t y, uint32_t color) override;
+  void drawLine(int32_t xs, int32_t ys, int32_t xe, int32_t ye, uint32_t color) override;
+  void drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color) override;
+  void drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color) override;
+  void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) override;
+  void drawGlyph(uint16_t code) override;
+  // TFT_eSPI's setRotation and writecommand aren't virtual, so these take their place and the originals can't be
+  // called on the display by mistake
+  void setDisplayRotation(uint8_t rotation);
+  void sendCommand(uint8_t command);
+  void setRotation(uint8_t rotation) = delete;
+  void writecommand(uint8_t command) = delete;
+
+ protected:
+  static void flushLoop(void *params);
+  void endPipeline();
+  void push(const TftDisplayRegion_t &region);
+  void shadowLine(int32_t xs, int32_t ys, int32_t xe, int32_t ye, uint32_t color);
+
+  TaskHandle_t _flushTask = nullptr;
+  QueueHandle_t _queuedRegions = nullptr;
+  QueueHandle_t _freeBuffers = nullptr;
+  // waitIdle takes every buffer, two tasks each holding some of them would wait on each other forever
+  SemaphoreHandle_t _idleLock = nullptr;
+  uint16_t *_buffers[TFT_DISPLAY_BUFFERS] = {};
+  volatile uint32_t _flushMicros = 0;
+  uint32_t _waitMicros = 0;
+  ShadowFramebuffer _shadow;
+};
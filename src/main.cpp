@@ -1,6 +1,7 @@
 #include <ArduinoJson.h>
 #include <ArduinoOTA.h>
 #include <base64.h>
+#include <driver/ledc.h>
 #include <driver/rtc_io.h>
 #include <esp_adc_cal.h>
 #include <esp_pm.h>
@@ -16,10 +17,8 @@
 #include <wifi_provisioning/manager.h>
 
 #include "main.h"
-#include "genres.h"
 
 void setup() {
-  spotifyImage.reserve(8192);
   exploreMenuItems.reserve(20);
   spotifyDevices.reserve(10);
   spotifyUsers.reserve(10);
@@ -63,32 +62,46 @@ void setup() {
     ledcSetup(backlightChannel, 12000, 8);
     ledcAttachPin(TFT_BL, backlightChannel);
     ledcWrite(backlightChannel, 255);
+    ledc_fade_func_install(0);
     tft.init();
     tft.fillScreen(TFT_BLACK);
   #endif
+  tft.beginPipeline();
+  #ifdef BOARD_HAS_PSRAM
+    tft.beginShadow();
+  #endif
 
   SPIFFS.begin(true);
   readDataJson();
+  albumArtCache.setup();
+  genreCatalog.setup();
   WiFi.setHostname(hostname);
   WiFi.begin();
   improvSerial.setup(hostname);
 
   setupKnob();
 
-  tft.setRotation(knobby.flippedDisplay() ? 1 : 3);
+  tft.setDisplayRotation(knobby.flippedDisplay() ? 1 : 3);
   tft.loadFont(GillSans24_vlw_start);
   img.loadFont(GillSans24_vlw_start);
   ico.loadFont(icomoon24_vlw_start);
   batterySprite.loadFont(icomoon31_vlw_start);
-
-  TJpgDec.setJpgScale(1);
-  TJpgDec.setSwapBytes(true);
-  TJpgDec.setCallback(onJpgBlockDecoded);
+  genreCatalog.useTextLayouts(textWidth, img.gFont.spaceWidth);
+  // the widest img draw is the seek bar, the tallest is the volume control or a line of text
+  spriteArena.setDisplay(&tft);
+  spriteArena.reserve(img, dividerWidth + seekRadius * 2, max(volumeControlHeight, img.gFont.yAdvance + lineSpacing));
+  spriteArena.reserve(ico, iconSpriteSize, iconSpriteSize + 1);
+  batterySprite.setColorDepth(4);
+  spriteArena.reserve(batterySprite, batterySize, batterySize);
+  iconAtlas.setup(iconSpriteSize, iconSpriteSize + 1);
+  textLineCache.setup(img.gFont.yAdvance + lineSpacing);
+  marquee.setup(GillSans24_vlw_start, img.gFont.yAdvance + lineSpacing);
+  fillIconAtlas();
 
   if (bootCount == 0) {
     log_d("Boot #%d", bootCount);
-    countryIndex = random(COUNTRY_COUNT);
-    genreIndex = random(GENRE_COUNT);
+    countryIndex = random(genreCatalog.countryCount());
+    genreIndex = random(genreCatalog.genreCount());
   } else {
     struct timeval tod;
     gettimeofday(&tod, NULL);
@@ -110,6 +123,8 @@ void setup() {
   }
   bootCount++;
 
+  clampCatalogIndexes();
+
   wifi_prov_mgr_config_t config;
   ESP_ERROR_CHECK(wifi_prov_mgr_init(config));
 
@@ -178,6 +193,7 @@ void setup() {
       html.replace("{{rotaryBPin}}", String(knobby.rotaryBPin()));
       html.replace("{{buttonPin}}", String(knobby.buttonPin()));
       html.replace("{{pulseCount}}", String(knobby.pulseCount()));
+      html.replace("{{catalogVersion}}", String(genreCatalog.version()) + (genreCatalog.isBuiltIn() ? " (built-in)" : ""));
       request->send(200, "text/html", html);
     }
   });
@@ -244,14 +260,50 @@ void setup() {
   server.on("/heap", HTTP_GET,
             [](AsyncWebServerRequest *request) { request->send(200, "text/plain", String(ESP.getFreeHeap())); });
 
+  server.on("/sprites", HTTP_GET, [](AsyncWebServerRequest *request) {
+    char stats[448];
+    snprintf(stats, sizeof(stats),
+             "allocations: %u\nallocated bytes: %u\nborrows: %u\nicon hits: %u\nicon misses: %u\n"
+             "text hits: %u\ntext misses: %u\ntext evictions: %u\ntext cells: %u / %u\n"
+             "album hits: %u\nalbum misses: %u\nalbum file hits: %u\nalbums cached: %u\nalbum files: %u\n"
+             "heap free: %u\nheap min free: %u\n",
+             spriteArena.allocations(), spriteArena.allocatedBytes(), spriteArena.borrows(), iconAtlas.hits(),
+             iconAtlas.misses(), textLineCache.hits(), textLineCache.misses(), textLineCache.evictions(),
+             textLineCache.cellsUsed(), textLineCache.cellCount(), albumArtCache.hits(), albumArtCache.misses(),
+             albumArtCache.fileHits(), albumArtCache.tilesUsed(), albumArtCache.filesUsed(), ESP.getFreeHeap(),
+             ESP.getMinFreeHeap());
+    request->send(200, "text/plain", stats);
+  });
+
+  server.on("/profile", HTTP_GET, [](AsyncWebServerRequest *request) {
+    AsyncResponseStream *response = request->beginResponseStream("text/plain");
+    renderProfiler.print(*response);
+    request->send(response);
+    if (request->hasParam("reset")) renderProfiler.reset();
+  });
+
+  server.on("/frames", HTTP_GET, [](AsyncWebServerRequest *request) {
+    char stats[448];
+    ShadowFramebuffer &shadow = tft.shadow();
+    snprintf(stats, sizeof(stats),
+             "max fps: %u\nrendered: %u\nskipped: %u\nlast us: %u\naverage us: %u\nmax us: %u\n"
+             "pipelined: %s\nflush us: %u\nwait us: %u\noverlap: %.0f%%\nflush stack free: %u\n"
+             "shadow: %s\nshadow flushes: %u\npixels pushed: %u\npixels unchanged: %u\nalbum decode us: %u\n",
+             frameScheduler.maxFps(), frameScheduler.framesRendered(), frameScheduler.framesSkipped(),
+             frameScheduler.lastFrameMicros(), frameScheduler.averageFrameMicros(), frameScheduler.maxFrameMicros(),
+             tft.pipelined() ? "yes" : "no", tft.flushMicros(), tft.waitMicros(), tft.overlapRatio() * 100,
+             tft.flushStackFree(), shadow.active() ? "yes" : "no", shadow.flushes(), shadow.pixelsPushed(),
+             shadow.pixelsSkipped(), albumDecodeMicros);
+    request->send(200, "text/plain", stats);
+  });
+
   server.on("/sleep", HTTP_GET, [](AsyncWebServerRequest *request) {
     AsyncWebParameter *passwordParam = request->getParam("pass");
     if (!passwordParam || passwordParam->value() != knobby.password()) {
       request->send(403, "text/plain", "Incorrect password");
     } else {
       request->send(200, "text/plain", "OK, sleeping");
-      delay(100);
-      startDeepSleep();
+      sleepRequested = true;
     }
   });
 
@@ -267,9 +319,7 @@ void setup() {
           bool flip = flippedParam->value() == "1";
           if (knobby.flippedDisplay() != flip) {
             knobby.setFlippedDisplay(flip);
-            tft.setRotation(knobby.flippedDisplay() ? 1 : 3);
-            tft.fillScreen(TFT_BLACK);
-            invalidateDisplay(true);
+            displayRotationRequested = true;
             changed = true;
           }
         }
@@ -338,10 +388,56 @@ void setup() {
           setStatusMessage("update failed");
         } else {
           log_i("OTA: update complete");
-          Serial.flush();
-          delay(100);
-          tft.fillScreen(TFT_BLACK);
-          ESP.restart();
+          restartRequested = true;
+        }
+      }
+    }
+  );
+
+  server.on("/catalog", HTTP_POST,
+    [](AsyncWebServerRequest *request) {},
+    [](AsyncWebServerRequest *request, const String& filename, size_t index, uint8_t *data, size_t len, bool final) {
+      AsyncWebParameter *passwordParam = request->getParam("pass", true);
+      if (!passwordParam || passwordParam->value() != knobby.password()) {
+        request->send(403, "text/plain", "Incorrect password");
+        return;
+      }
+
+      if (!index) {
+        catalogContentLength = request->contentLength();
+        // the loop has to stop reading the partition before it's erased
+        if (!genreCatalog.isBuiltIn()) {
+          catalogSwapRequested = true;
+          const auto started = millis();
+          while (catalogSwapRequested && millis() - started < catalogSwapTimeoutMillis) delay(10);
+        }
+        log_i("catalog: receiving %u bytes", catalogContentLength);
+        catalogUpdateFailed = !genreCatalog.beginUpdate(0);
+        catalogSwapRequested = false;
+      }
+
+      if (!catalogUpdateFailed && !genreCatalog.writeUpdate(data, len)) {
+        log_e("catalog: write failed at %u", index);
+        catalogUpdateFailed = true;
+      }
+
+      if (final) {
+        if (catalogUpdateFailed || !genreCatalog.endUpdate()) {
+          catalogContentLength = 0;
+          if (genreCatalog.isBuiltIn()) {
+            request->send(400, "text/plain", "Invalid catalog, using built-in genres until restart");
+          } else {
+            request->send(503, "text/plain", "Catalog is in use, try again");
+          }
+          setStatusMessage("update failed");
+        } else {
+          AsyncWebServerResponse *response = request->beginResponse(302, "text/plain", "Rebooting, please wait...");
+          response->addHeader("Refresh", "10");
+          response->addHeader("Location", "/");
+          request->send(response);
+          catalogContentLength = 0;
+          log_i("catalog: update complete");
+          restartRequested = true;
         }
       }
     }
@@ -363,8 +459,11 @@ void setup() {
     spotifyActionQueue.push_front(GetToken);
   }
 
+  playlistIndexLock = xSemaphoreCreateMutex();
+  backgroundApiLock = xSemaphoreCreateMutex();
   xTaskCreatePinnedToCore(backgroundApiLoop, "backgroundApi", 10000, NULL, 1, &backgroundApiTask, 1);
-  xTaskCreatePinnedToCore(jpgDecodeLoop, "jpgDecode", 10000, NULL, 0, &jpgDecodeTask, 0);
+  // sleeps until there's an album image to decode, below the display flush task on the same core
+  xTaskCreatePinnedToCore(jpgDecodeLoop, "jpgDecode", 10000, NULL, 1, &jpgDecodeTask, 0);
 
   if (knobby.powerStatus() != PowerStatusPowered) knobby.updateBattery();
   if (knobby.powerStatus() == PowerStatusPowered) knobby.printHeader(wifiProvisioned);
@@ -427,6 +526,9 @@ void delayIfIdle() {
       (isIdle() || now - lastDelayMillis > 2000)) {
     delay(1);
     lastDelayMillis = now;
+  } else if (randomizingMenuEndMillis > 0 && !displayInvalidated) {
+    // nothing to draw until the next tick
+    delay(constrain(animationTimeline.millisUntilKeyframe(now), 1, animationWaitMillis));
   } else if (randomizingMenuEndMillis == 0 && updateContentLength == 0) {
     delay(1);
   }
@@ -440,6 +542,26 @@ void loop() {
   knobby.loop();
   shutdownIfLowBattery();
 
+  if (catalogSwapRequested) swapToBuiltInCatalog();
+  if (restartRequested) {
+    // give the response time to go out first
+    Serial.flush();
+    delay(100);
+    tft.fillScreen(TFT_BLACK);
+    tft.flushShadow();
+    ESP.restart();
+  }
+  if (sleepRequested) {
+    delay(100);
+    startDeepSleep();
+  }
+  if (displayRotationRequested) {
+    displayRotationRequested = false;
+    tft.setDisplayRotation(knobby.flippedDisplay() ? 1 : 3);
+    tft.fillScreen(TFT_BLACK);
+    invalidateDisplay(true);
+  }
+
   now = millis();
   unsigned long inputDelta = (now == lastInputMillis) ? 1 : now - lastInputMillis;
   bool connected = WiFi.isConnected();
@@ -450,6 +572,7 @@ void loop() {
     if (menuMode == NowPlaying && now - spotifyState.lastUpdateMillis > 5000) {
       nextCurrentlyPlayingMillis = 1;
     }
+    animationTimeline.stop(BacklightFadeAnimation);
     #ifdef LILYGO_WATCH_2019_WITH_TOUCH
       ttgo->bl->begin();
       ttgo->bl->adjust(255);
@@ -461,22 +584,7 @@ void loop() {
   } else if (inputDelta > inactivityMillis + 2 * inactivityFadeOutMillis) {
     startDeepSleep();
   } else if (inputDelta > inactivityMillis) {
-    double fadeProgress = 1.0 - (inputDelta - inactivityMillis) / (double)inactivityFadeOutMillis;
-    #ifdef LILYGO_WATCH_2019_WITH_TOUCH
-      const int minimumDuty = 99;
-    #else
-      const int minimumDuty = 5;
-    #endif
-    uint32_t duty = min(max((int)round(fadeProgress * 255.0), minimumDuty), 255);
-    if (duty >= 250) {
-      setLightSleepEnabled(false);
-    }
-    #ifdef LILYGO_WATCH_2019_WITH_TOUCH
-      ttgo->setBrightness(duty);
-    #else
-      if (duty >= 250) ledcAttachPin(TFT_BL, backlightChannel);
-      ledcWrite(backlightChannel, duty);
-    #endif
+    fadeBacklight(now);
   } else if (menuMode == VolumeControl && inputDelta > menuTimeoutMillis) {
     setMenuMode(NowPlaying, VolumeButton);
     if (nextCurrentlyPlayingMillis == 0) nextCurrentlyPlayingMillis = 1;
@@ -533,7 +641,7 @@ void loop() {
 
   if (randomizingMenuEndMillis > 0 && now >= randomizingMenuEndMillis) {
     randomizingMenuEndMillis = 0;
-    randomizingMenuNextMillis = 0;
+    animationTimeline.stop(RandomizingAnimation);
     if (randomizingMenuAutoplay) {
       spotifyActionQueue.clear();
       playMenuPlaylist(lastPlaylistMenuMode, menuIndex);
@@ -548,25 +656,36 @@ void loop() {
         min(spotifyState.durationMillis, spotifyState.progressMillis + (now - spotifyState.lastUpdateMillis));
   }
 
-  if (statusMessageUntilMillis > 0 && now >= statusMessageUntilMillis) {
-    statusMessageUntilMillis = 0;
+  if (frameScheduler.widgetDue(StatusMessageWidget, now)) {
     statusMessage[0] = '\0';
     tft.fillRect(0, 1, screenWidth, 31, TFT_BLACK);
     showingStatusMessage = false;
     invalidateDisplay();
-  } else if (clickEffectEndMillis > 0 && now > clickEffectEndMillis) {
-    clickEffectEndMillis = 0;
+  } else if (animationTimeline.keyframeDue(ClickEffectAnimation, now)) {
+    animationTimeline.stop(ClickEffectAnimation);
     invalidateDisplay();
-  } else if ((randomizingMenuNextMillis > 0 && now >= randomizingMenuNextMillis) ||
+  } else if (!displayInvalidated &&
+             (animationTimeline.keyframeDue(RandomizingAnimation, now) ||
               lastInputMillis > lastDisplayMillis || (now - lastDisplayMillis > extraLongPressMillis) ||
-              (shouldShowRandom() && lastDisplayMillis < longPressStartedMillis + extraLongPressMillis * 2)) {
+              (shouldShowRandom() && lastDisplayMillis < longPressStartedMillis + extraLongPressMillis * 2))) {
     invalidateDisplay();
   }
 
-  if (displayInvalidated && updateContentLength == 0) updateDisplay();
+  if (displayInvalidated && updateContentLength == 0 && frameScheduler.frameDue(millis())) {
+    updateDisplay();
+    if (showingRenderStats) drawRenderStats();
+  } else if (!displayInvalidated && updateContentLength == 0) {
+    prefetchMenuNeighbors();
+  }
 
   auto top = menuMode == NowPlaying ? lineDivider : 0;
-  if (shouldShowProgressBar()) {
+  now = millis();
+  const bool progressBar = shouldShowProgressBar();
+  if (progressBar && !animationTimeline.running(ProgressSweepAnimation)) {
+    animationTimeline.start(ProgressSweepAnimation, now);
+  }
+  if (progressBar && animationTimeline.keyframeDue(ProgressSweepAnimation, now)) {
+    animationTimeline.nextKeyframe(ProgressSweepAnimation, now + frameScheduler.frameIntervalMillis());
     unsigned long margin = menuMode == NowPlaying ? 4 : 0;
     unsigned long maxWidth = tft.width() - margin * 2;
     unsigned long width = 59;
@@ -577,12 +696,19 @@ void loop() {
       if (x + width > maxWidth) width -= (x + width) - maxWidth;
       tft.drawFastHLine(x, top, width, segment % 2 == 0 ? TFT_DARKERGREY : TFT_DARKGREY);
     }
-  } else if (showingProgressBar) {
+  } else if (showingProgressBar && !progressBar) {
+    animationTimeline.stop(ProgressSweepAnimation);
     tft.drawFastHLine(0, top, tft.width(), TFT_BLACK);
     showingProgressBar = false;
     updateDisplay();
   }
 
+  if (animationTimeline.keyframeDue(MarqueeAnimation, now)) {
+    animationTimeline.nextKeyframe(MarqueeAnimation, now + frameScheduler.frameIntervalMillis());
+    marquee.draw(tft, now);
+  }
+  tft.flushShadow();
+
   ArduinoOTA.handle();
   improvSerial.loop();
   if (wifiManager) wifiManager->loop();
@@ -593,6 +719,41 @@ void loop() {
   delayIfIdle();
 }
 
+void fadeBacklight(unsigned long now) {
+  #ifdef LILYGO_WATCH_2019_WITH_TOUCH
+    const uint32_t minimumDuty = 99;
+  #else
+    const uint32_t minimumDuty = 5;
+  #endif
+  if (!animationTimeline.running(BacklightFadeAnimation)) {
+    animationTimeline.start(BacklightFadeAnimation, now);
+    setLightSleepEnabled(false);
+    #ifndef LILYGO_WATCH_2019_WITH_TOUCH
+      // the LEDC steps the duty down on its own from here, arduino channels 0-7 are in the first speed mode
+      const auto speedMode = (ledc_mode_t)(backlightChannel / 8);
+      const auto channel = (ledc_channel_t)(backlightChannel % 8);
+      ledcWrite(backlightChannel, 255);
+      ledcAttachPin(TFT_BL, backlightChannel);
+      ledc_set_fade_with_time(speedMode, channel, minimumDuty, inactivityFadeOutMillis);
+      ledc_fade_start(speedMode, channel, LEDC_FADE_NO_WAIT);
+      animationTimeline.nextKeyframe(BacklightFadeAnimation, now + inactivityFadeOutMillis);
+    #endif
+  }
+  if (!animationTimeline.keyframeDue(BacklightFadeAnimation, now)) return;
+
+  const unsigned long elapsed = min(animationTimeline.elapsedMillis(BacklightFadeAnimation, now),
+                                    (unsigned long)inactivityFadeOutMillis);
+  #ifdef LILYGO_WATCH_2019_WITH_TOUCH
+    ttgo->setBrightness(max((uint32_t)(255 * (inactivityFadeOutMillis - elapsed) / inactivityFadeOutMillis), minimumDuty));
+  #endif
+  if (elapsed < inactivityFadeOutMillis) {
+    animationTimeline.nextKeyframe(BacklightFadeAnimation, now + backlightFadeStepMillis);
+  } else {
+    // faded all the way, the next thing to happen is going to sleep
+    animationTimeline.nextKeyframe(BacklightFadeAnimation, lastInputMillis + inactivityMillis + 2 * inactivityFadeOutMillis);
+  }
+}
+
 void backgroundApiLoop(void *params) {
   for (;;) {
     delayIfIdle();
@@ -605,6 +766,7 @@ void backgroundApiLoop(void *params) {
     }
 
     if (spotifyActionQueue.size() > 0) {
+      xSemaphoreTake(backgroundApiLock, portMAX_DELAY);
       spotifyAction = spotifyActionQueue.front();
       spotifyActionQueue.pop_front();
 
@@ -675,26 +837,27 @@ void backgroundApiLoop(void *params) {
       }
       now = millis();
       spotifyAction = Idle;
+      xSemaphoreGive(backgroundApiLock);
     }
 
     if (nextCurrentlyPlayingMillis > 0 && now >= nextCurrentlyPlayingMillis) {
       nextCurrentlyPlayingMillis = 0;
       spotifyQueueAction(CurrentlyPlaying);
-    } else if (spotifyState.trackId[0] != '\0') {
+    } else if (!spotifyState.trackId.isEmpty()) {
       if (!spotifyState.checkedLike) spotifyQueueAction(CheckLike);
     }
   }
 }
 
 void addExploreMenuTrackInfo() {
-  if (spotifyState.trackId[0] == '\0') return;
+  if (spotifyState.trackId.isEmpty()) return;
 
   for (auto artist : spotifyState.artists) {
-    if (artist.id[0] == '\0' || artist.name[0] == '\0') break;
+    if (artist.id.isEmpty() || artist.name[0] == '\0') break;
 
     ExploreItem_t item;
     item.type = ExploreItemArtist;
-    strncpy(item.id, artist.id, SPOTIFY_ID_SIZE);
+    item.id = artist.id;
     const char artistPrefix[] = "artist: ";
     item.name.reserve(sizeof(artistPrefix) + strlen(artist.name));
     item.name.concat(artistPrefix);
@@ -702,10 +865,10 @@ void addExploreMenuTrackInfo() {
     exploreMenuItems.push_back(item);
   }
 
-  if (spotifyState.albumId[0] != '\0' && spotifyState.albumName[0] != '\0') {
+  if (!spotifyState.albumId.isEmpty() && spotifyState.albumName[0] != '\0') {
     ExploreItem_t item;
     item.type = ExploreItemAlbum;
-    strncpy(item.id, spotifyState.albumId, SPOTIFY_ID_SIZE);
+    item.id = spotifyState.albumId;
     const char albumPrefix[] = "album: ";
     item.name.reserve(sizeof(albumPrefix) + strlen(spotifyState.albumName));
     item.name.concat(albumPrefix);
@@ -714,11 +877,30 @@ void addExploreMenuTrackInfo() {
   }
 }
 
+void addExploreMenuSimilarGenres(int genreIndex) {
+  if (genreIndex < 0 || genreIndex >= genreCatalog.genreCount()) return;
+  auto neighbors = genreCatalog.genreNeighbors(genreIndex);
+  if (!neighbors) return;
+
+  for (auto i = 0; i < genreCatalog.genreNeighborCount(); i++) {
+    ExploreItem_t item;
+    item.type = ExploreItemPlaylist;
+    item.id = genreCatalog.genrePlaylist(neighbors[i]);
+    const char similarPrefix[] = "similar: ";
+    char name[GENRE_NAME_SIZE];
+    genreCatalog.genreName(neighbors[i], name, sizeof(name));
+    item.name.reserve(sizeof(similarPrefix) + strlen(name));
+    item.name.concat(similarPrefix);
+    item.name.concat(name);
+    exploreMenuItems.push_back(item);
+  }
+}
+
 void selectRootMenuItem(uint16_t index) {
   checkMenuSize(RootMenu);
   if (index == rootMenuExploreIndex) {
     auto activeGenreIndex = -1;
-    const String contextUri = spotifyState.contextUri;
+    const auto contextPlaylistId = getSpotifyIdFromUri(spotifyState.contextUri, spotifyPlaylistContextPrefix);
     if (spotifyState.isPlaying || lastMenuMode == NowPlaying) {
       activeGenreIndex = playingGenreIndex;
     } else if (isGenreMenu(lastMenuMode)) {
@@ -726,14 +908,15 @@ void selectRootMenuItem(uint16_t index) {
     }
     exploreMenuItems.clear();
     addExploreMenuTrackInfo();
+    addExploreMenuSimilarGenres(activeGenreIndex);
     if (explorePlaylistsGenreIndex == activeGenreIndex && explorePlaylists.size() > 0) {
       exploreMenuItems.insert(exploreMenuItems.end(), explorePlaylists.begin(), explorePlaylists.end());
     } else if (activeGenreIndex >= 0) {
       explorePlaylistsGenreIndex = activeGenreIndex;
-      strncpy(spotifyGetPlaylistId, genrePlaylists[activeGenreIndex], SPOTIFY_ID_SIZE);
+      spotifyGetPlaylistId = genreCatalog.genrePlaylist(activeGenreIndex);
       spotifyQueueAction(GetPlaylistInformation);
-    } else if (contextUri.startsWith(spotifyPlaylistContextPrefix) && !contextUri.endsWith(spotifyGetPlaylistId)) {
-      strncpy(spotifyGetPlaylistId, contextUri.c_str() + strlen(spotifyPlaylistContextPrefix), SPOTIFY_ID_SIZE);
+    } else if (!contextPlaylistId.isEmpty() && contextPlaylistId != spotifyGetPlaylistId) {
+      spotifyGetPlaylistId = contextPlaylistId;
       spotifyQueueAction(GetPlaylistInformation);
     }
     setMenuMode(ExploreList, lastMenuMode == ExploreList ? lastMenuIndex : 0);
@@ -821,6 +1004,11 @@ void knobRotated() {
   menuSize = checkMenuSize(menuMode);
   if (menuSize == 0) return;
 
+  // spinning quickly through an alphabetical list skips to the next letter pair, or the next letter when faster
+  bool alphabeticalList = menuMode == CountryList || (menuMode == GenreList && genreSort == AlphabeticSort);
+  bool jumpByPrefix = false;
+  bool jumpByFirstLetter = false;
+
   int knobDirection = knobDelta > 0 ? 1 : -1;
   if (lastInputDelta > 333 || knobDirection != lastKnobDirection) {
     lastKnobDirection = knobDirection;
@@ -832,7 +1020,10 @@ void knobRotated() {
     float averageKnobVelocity = 0.0;
     for (auto v : knobVelocity) averageKnobVelocity += (v);
     averageKnobVelocity = averageKnobVelocity / (float)knobVelocity.size();
-    if(averageKnobVelocity > 0.04) {
+    if (alphabeticalList && averageKnobVelocity > 0.04) {
+      jumpByPrefix = true;
+      jumpByFirstLetter = averageKnobVelocity > 0.08;
+    } else if(averageKnobVelocity > 0.04) {
       positionDelta *= 10;
     } else if (averageKnobVelocity > 0.08) {
       positionDelta *= 100;
@@ -847,6 +1038,17 @@ void knobRotated() {
       spotifySetVolumeTo = menuIndex;
       spotifyQueueAction(SetVolume);
     }
+  } else if (jumpByPrefix) {
+    int direction = positionDelta > 0 ? 1 : -1;
+    uint16_t newMenuIndex = menuIndex;
+    for (auto i = 0; i < abs(positionDelta); i++) {
+      if (menuMode == CountryList) {
+        newMenuIndex = genreCatalog.countryPrefixJump(newMenuIndex, direction, jumpByFirstLetter);
+      } else {
+        newMenuIndex = genreCatalog.genrePrefixJump(newMenuIndex, direction, jumpByFirstLetter);
+      }
+    }
+    setMenuIndex(newMenuIndex);
   } else {
     int newMenuIndex = ((int)menuIndex + positionDelta) % (int)menuSize;
     if (newMenuIndex < 0) newMenuIndex += menuSize;
@@ -866,8 +1068,11 @@ void knobClicked() {
   }
   if (pressedMenuIndex < 0) return;
   menuClickedMillis = lastInputMillis;
-  clickEffectEndMillis = lastInputMillis + clickEffectMillis;
-  if (randomizingMenuEndMillis > 0) randomizingMenuEndMillis = 0;
+  animationTimeline.start(ClickEffectAnimation, lastInputMillis, clickEffectMillis);
+  if (randomizingMenuEndMillis > 0) {
+    randomizingMenuEndMillis = 0;
+    animationTimeline.stop(RandomizingAnimation);
+  }
 
   switch (menuMode) {
     case RootMenu:
@@ -897,7 +1102,7 @@ void knobClicked() {
           spotifyQueueAction(spotifyRetryAction);
           spotifyRetryAction = Idle;
           nextCurrentlyPlayingMillis = lastInputMillis + SPOTIFY_WAIT_MILLIS;
-        } else if (spotifyState.isPlaying && !spotifyGettingToken && spotifyState.trackId[0] != '\0' &&
+        } else if (spotifyState.isPlaying && !spotifyGettingToken && !spotifyState.trackId.isEmpty() &&
             (!activeSpotifyDevice || strcmp(activeSpotifyDevice->id, spotifyDevices[pressedMenuIndex].id) != 0)) {
           spotifyQueueAction(TransferPlayback);
         }
@@ -932,7 +1137,7 @@ void knobClicked() {
     case NowPlaying:
       switch (pressedMenuIndex) {
         case LikeButton:
-          if (spotifyState.trackId[0] != '\0') {
+          if (!spotifyState.trackId.isEmpty()) {
             spotifyQueueAction(ToggleLike);
           }
           break;
@@ -989,7 +1194,9 @@ void knobDoubleClicked() {
     return;
   }
   if (menuMode == GenreList) {
-    genreSort = (GenreSortModes)((genreSort + 1) % genreSortModesCount);
+    do {
+      genreSort = (GenreSortModes)((genreSort + 1) % genreSortModesCount);
+    } while (genreSort != AlphabeticSort && !genreCatalog.genreIndexes(genreSort));
     setMenuIndex(getMenuIndexForGenreIndex(genreIndex));
     switch (genreSort) {
       case AlphabeticSort:
@@ -998,22 +1205,45 @@ void knobDoubleClicked() {
       case AlphabeticSuffixSort:
         setStatusMessage("sort by suffix");
         break;
+      case BackgroundSort:
+        setStatusMessage("sort by background");
+        break;
+      case ModernitySort:
+        setStatusMessage("sort by modernity");
+        break;
+      case PopularitySort:
+        setStatusMessage("sort by popularity");
+        break;
     }
   } else if (menuMode == SettingsMenu) {
     switch (menuIndex) {
       case SettingsAbout:
-        showingNetworkInfo = !showingNetworkInfo;
-        invalidateDisplay();
+        // a third double click, which nothing on screen mentions, shows render stats over everything
+        if (showingNetworkInfo && !showingRenderStats) {
+          showingRenderStats = true;
+        } else {
+          showingNetworkInfo = !showingNetworkInfo;
+          showingRenderStats = false;
+        }
+        invalidateDisplay(true);
         break;
       case SettingsUpdate:
         updateFirmware();
         break;
       case SettingsOrientation:
         knobby.setFlippedDisplay(!knobby.flippedDisplay());
-        tft.setRotation(knobby.flippedDisplay() ? 1 : 3);
+        tft.setDisplayRotation(knobby.flippedDisplay() ? 1 : 3);
         invalidateDisplay(true);
         writeDataJson();
         break;
+      case SettingsRandom:
+        if (genreCatalog.hasPopularityWeights()) {
+          randomByPopularity = !randomByPopularity;
+          setStatusMessage(randomByPopularity ? "by popularity" : "all equal");
+          invalidateDisplay();
+          writeDataJson();
+        }
+        break;
       case SettingsAddUser:
         if (strcmp(WiFi.getHostname(), "knobby") != 0) {
           MDNS.end();
@@ -1036,6 +1266,7 @@ void knobDoubleClicked() {
           writeDataJson();
           delay(statusMessageMillis);
           tft.fillScreen(TFT_BLACK);
+          tft.flushShadow();
           ESP.restart();
         }
         break;
@@ -1044,6 +1275,7 @@ void knobDoubleClicked() {
         tft.setCursor(textStartX, lineTwo);
         img.setTextColor(TFT_WHITE, TFT_BLACK);
         drawCenteredText("resetting...", textWidth, 1);
+        tft.flushShadow();
         spotifyAccessToken[0] = '\0';
         spotifyRefreshToken[0] = '\0';
         spotifyUsers.clear();
@@ -1051,6 +1283,7 @@ void knobDoubleClicked() {
         WiFi.disconnect(true, true);
         delay(statusMessageMillis);
         tft.fillScreen(TFT_BLACK);
+        tft.flushShadow();
         ESP.restart();
         break;
       default:
@@ -1114,9 +1347,8 @@ void knobLongPressStopped() {
 }
 
 void drawBattery(unsigned int percent, unsigned int y, bool charging) {
-  const unsigned int batterySize = 31;
-  batterySprite.createSprite(batterySize, batterySize);
-  batterySprite.fillSprite(TFT_BLACK);
+  RenderTimer timer(BatteryTiming);
+  if (!spriteArena.borrow(batterySprite, batterySize, batterySize)) return;
   batterySprite.setTextDatum(MC_DATUM);
   batterySprite.setTextColor(TFT_DARKERGREY, TFT_BLACK);
   batterySprite.setCursor(1, 3);
@@ -1136,8 +1368,8 @@ void drawBattery(unsigned int percent, unsigned int y, bool charging) {
     }
   }
   tft.setCursor(centerX - batterySize / 2, y);
-  batterySprite.pushSprite(tft.getCursorX(), tft.getCursorY());
-  batterySprite.deleteSprite();
+  spriteArena.push(batterySprite, tft.getCursorX(), tft.getCursorY());
+  spriteArena.giveBack(batterySprite);
 }
 
 void shutdownIfLowBattery() {
@@ -1148,19 +1380,25 @@ void shutdownIfLowBattery() {
   log_i("Battery voltage is %.3f V, shutting down!", knobby.batteryVoltage());
   tft.fillScreen(TFT_BLACK);
   drawBattery(0, 50);
+  tft.flushShadow();
   delay(333);
   tft.fillScreen(TFT_BLACK);
+  tft.flushShadow();
   delay(333);
   drawBattery(0, 50);
+  tft.flushShadow();
   delay(333);
   tft.fillScreen(TFT_BLACK);
+  tft.flushShadow();
   delay(333);
   drawBattery(0, 50);
+  tft.flushShadow();
   delay(333);
   startDeepSleep();
 }
 
 void drawDivider(bool selected) {
+  RenderTimer timer(DividerTiming);
   if (selected) {
     tft.drawFastHLine(6, lineDivider, screenWidth - 12, TFT_LIGHTGREY);
   } else {
@@ -1171,17 +1409,38 @@ void drawDivider(bool selected) {
 }
 
 void drawIcon(const String& icon, bool selected, bool clicked, bool disabled, bool filled) {
+  RenderTimer timer(IconTiming);
+  uint16_t pos = 0;
+  const uint16_t code = ico.decodeUTF8((uint8_t *)icon.c_str(), &pos, icon.length());
+  const IconStates state = clicked    ? IconClicked
+                           : filled   ? (selected ? IconFilledSelected : IconFilled)
+                           : disabled ? (selected ? IconDisabledSelected : IconDisabled)
+                                      : (selected ? IconSelected : IconNormal);
+  if (iconAtlas.draw(tft, code, state, tft.getCursorX(), tft.getCursorY())) return;
+
+  if (!renderIcon(icon, state)) return;
+  iconAtlas.store(code, state, (const uint16_t *)ico.getPointer(), ico.width());
+  spriteArena.push(ico, tft.getCursorX(), tft.getCursorY());
+  spriteArena.giveBack(ico);
+}
+
+// draw an icon into the top left of ico, which is left borrowed for the caller to push and give back, or false if ico
+// couldn't be borrowed
+bool renderIcon(const String& icon, IconStates state) {
+  const bool selected = state == IconSelected || state == IconDisabledSelected || state == IconFilledSelected;
+  const bool clicked = state == IconClicked;
+  const bool filled = state == IconFilled || state == IconFilledSelected;
+  const bool disabled = state == IconDisabled || state == IconDisabledSelected;
   ico.setTextDatum(MC_DATUM);
-  const int width = ICON_SIZE + 2;
-  const int height = ICON_SIZE + 2;
-  ico.createSprite(width, height + 1);
+  const int width = iconSpriteSize;
+  const int height = iconSpriteSize;
+  if (!spriteArena.borrow(ico, width, height + 1)) return false;
 
   const uint16_t bg = TFT_BLACK;
   const uint16_t fg = TFT_DARKGREY;
   const uint16_t fgActive = TFT_LIGHTGREY;
   const uint16_t fgDisabled = TFT_DARKERGREY;
 
-  ico.fillSprite(bg);
   if (clicked) {
     ico.fillRoundRect(0, 0, width, height, 3, fgActive);
     ico.setTextColor(bg, fgActive);
@@ -1198,11 +1457,29 @@ void drawIcon(const String& icon, bool selected, bool clicked, bool disabled, bo
   ico.setCursor(1, 4);
   ico.printToSprite(icon);
   if (selected) ico.drawRoundRect(0, 0, width, height, 3, fgActive);
-  ico.pushSprite(tft.getCursorX(), tft.getCursorY());
-  ico.deleteSprite();
+  return true;
+}
+
+// render every state of the control row icons up front, when there's PSRAM for all of them
+void fillIconAtlas() {
+#ifdef BOARD_HAS_PSRAM
+  const String *icons[] = {&ICON_FAVORITE,   &ICON_FAVORITE_OUTLINE, &ICON_SHUFFLE,     &ICON_SKIP_PREVIOUS,
+                           &ICON_PLAY_ARROW, &ICON_PAUSE,            &ICON_SKIP_NEXT,   &ICON_REPEAT,
+                           &ICON_REPEAT_ONE, &ICON_VOLUME_UP,        &ICON_VOLUME_DOWN, &ICON_VOLUME_MUTE};
+  for (auto icon : icons) {
+    uint16_t pos = 0;
+    const uint16_t code = ico.decodeUTF8((uint8_t *)icon->c_str(), &pos, icon->length());
+    for (auto state = (int)IconNormal; state <= IconClicked; state++) {
+      if (!renderIcon(*icon, (IconStates)state)) continue;
+      iconAtlas.store(code, (IconStates)state, (const uint16_t *)ico.getPointer(), ico.width());
+      spriteArena.giveBack(ico);
+    }
+  }
+#endif
 }
 
 void drawStatusMessage() {
+  RenderTimer timer(StatusMessageTiming);
   if(!showingStatusMessage) {
     showingStatusMessage = true;
     tft.fillRect(0, 1, screenWidth, 31, TFT_BLACK);
@@ -1213,6 +1490,7 @@ void drawStatusMessage() {
 }
 
 void drawMenuHeader(bool selected, const char *text, int totalSize) {
+  RenderTimer timer(MenuHeaderTiming);
   if (totalSize < 0) totalSize = menuSize;
   if (statusMessage[0] != '\0') {
     drawStatusMessage();
@@ -1238,6 +1516,7 @@ void drawMenuHeader(bool selected, const char *text, int totalSize) {
 }
 
 void drawSetup() {
+  RenderTimer timer(SetupTiming);
   drawMenuHeader(true, "setup knobby");
   img.setTextColor(TFT_LIGHTGREY, TFT_BLACK);
   if (wifiConnectWarning) {
@@ -1266,14 +1545,19 @@ void drawSetup() {
 }
 
 void drawRandomizing() {
-  if (millis() < randomizingMenuNextMillis) return;
+  RenderTimer timer(RandomizingTiming);
+  if (!animationTimeline.keyframeDue(RandomizingAnimation, millis())) return;
   randomizingMenuTicks++;
-  randomizingMenuNextMillis = millis() + max((int)(pow(randomizingMenuTicks, 3) + pow(randomizingMenuTicks, 2)), 10);
-  setMenuIndex(random(checkMenuSize(lastPlaylistMenuMode)));
+  animationTimeline.nextKeyframe(RandomizingAnimation, millis() + max((int)(randomizingMenuTicks * randomizingMenuTicks * (randomizingMenuTicks + 1)), 10));
+  if (lastPlaylistMenuMode == GenreList) {
+    setMenuIndex(getMenuIndexForGenreIndex(genreCatalog.randomGenre(randomByPopularity)));
+  } else {
+    setMenuIndex(random(checkMenuSize(lastPlaylistMenuMode)));
+  }
   char contextName[sizeof(SpotifyState_t::contextName)];
   tft.setCursor(textStartX, lineTwo);
   if (isGenreMenu(lastPlaylistMenuMode)) {
-    img.setTextColor(genreColors[genreIndex], TFT_BLACK);
+    img.setTextColor(genreCatalog.genreColor(genreIndex), TFT_BLACK);
     getMenuText(contextName, lastPlaylistMenuMode, menuIndex);
   } else if (lastPlaylistMenuMode == CountryList) {
     getMenuText(contextName, lastPlaylistMenuMode, menuIndex);
@@ -1284,6 +1568,7 @@ void drawRandomizing() {
 }
 
 void drawRootMenu() {
+  RenderTimer timer(RootMenuTiming);
   const int textPadding = 24;
   const int textStartX = textPadding + 1;
   const int textWidth = screenWidth - textPadding * 2;
@@ -1325,6 +1610,7 @@ void drawRootMenu() {
 }
 
 void drawSettingsMenu() {
+  RenderTimer timer(SettingsMenuTiming);
   img.setTextColor(TFT_DARKGREY, TFT_BLACK);
   tft.setCursor(textStartX, lineTwo);
   switch (menuIndex) {
@@ -1347,6 +1633,15 @@ void drawSettingsMenu() {
     case SettingsOrientation:
       drawCenteredText("double click to rotate the display", textWidth, 3);
       break;
+    case SettingsRandom:
+      if (!genreCatalog.hasPopularityWeights()) {
+        drawCenteredText("random genres are all equally likely", textWidth, 3);
+      } else if (randomByPopularity) {
+        drawCenteredText("double click to make random genres equally likely", textWidth, 3);
+      } else {
+        drawCenteredText("double click to pick random genres by popularity", textWidth, 3);
+      }
+      break;
     case SettingsAddUser:
       if (strcmp(WiFi.getHostname(), "knobby") != 0) {
         drawCenteredText("double click to add a spotify account", textWidth, 3);
@@ -1369,6 +1664,7 @@ void drawSettingsMenu() {
 }
 
 void drawUserMenu() {
+  RenderTimer timer(UserMenuTiming);
   SpotifyUser_t *user = &spotifyUsers[menuIndex];
   bool selected = user == activeSpotifyUser;
   drawMenuHeader(selected);
@@ -1385,6 +1681,7 @@ void drawUserMenu() {
 }
 
 void drawDeviceMenu() {
+  RenderTimer timer(DeviceMenuTiming);
   if (spotifyDevicesLoaded && !spotifyDevices.empty()) {
     SpotifyDevice_t *device = &spotifyDevices[menuIndex];
     bool selected = device == activeSpotifyDevice;
@@ -1411,6 +1708,7 @@ void drawDeviceMenu() {
 }
 
 void drawVolumeControl() {
+  RenderTimer timer(VolumeControlTiming);
   const auto x = 10;
   const auto y = 30;
   const auto padding = 4;
@@ -1420,12 +1718,12 @@ void drawVolumeControl() {
   const auto innerRadius = 3;
   const auto innerWidth = outerWidth - padding * 2;
   const auto innerHeight = outerHeight - padding * 2;
-  img.createSprite(outerWidth, 40);
-  img.fillSprite(TFT_BLACK);
-  img.drawRoundRect(0, 0, outerWidth, outerHeight, outerRadius, TFT_WHITE);
-  img.fillRoundRect(padding, padding, round(0.01 * menuIndex * innerWidth), innerHeight, innerRadius, TFT_DARKGREY);
-  img.pushSprite(x, y);
-  img.deleteSprite();
+  if (spriteArena.borrow(img, outerWidth, volumeControlHeight)) {
+    img.drawRoundRect(0, 0, outerWidth, outerHeight, outerRadius, TFT_WHITE);
+    img.fillRoundRect(padding, padding, round(0.01 * menuIndex * innerWidth), innerHeight, innerRadius, TFT_DARKGREY);
+    spriteArena.push(img, x, y);
+    spriteArena.giveBack(img);
+  }
 
   char label[7];
   sprintf(label, "%d%%", menuIndex);
@@ -1434,22 +1732,28 @@ void drawVolumeControl() {
   drawCenteredText(label, textWidth, 1);
 }
 
+bool albumImageAvailable() {
+  return spotifyState.imageUrl[0] != '\0' && albumArtCache.cached(albumArtCache.key(spotifyState.imageUrl));
+}
+
 void drawAlbumImage() {
-  if (spotifyImage.isEmpty() || (spotifyImageDrawn && displayInvalidatedPartial)) return;
+  RenderTimer timer(AlbumImageTiming);
+  if (spotifyImageDrawn && displayInvalidatedPartial) return;
+  if (spotifyState.imageUrl[0] == '\0') return;
 
-  jpgRenderReady = false;
-  jpgDecodeReady = true;
-  while(jpgDecodeReady || jpgRenderReady) {
-    if (jpgRenderReady) {
-      tft.pushImage(albumX + jpgBlockX, albumY + jpgBlockY, jpgBlockW, jpgBlockH, jpgBlockBuffer);
-      jpgRenderReady = false;
-    }
-    yield();
-  }
+  // decoded on the other core as it downloads, until then there's nothing to draw
+  if (!albumArtCache.draw(albumArtCache.key(spotifyState.imageUrl), tft, albumX, albumY)) return;
   spotifyImageDrawn = true;
+  const uint32_t started = albumDecodeStartedMicros;
+  if (started != 0) {
+    albumDecodeStartedMicros = 0;
+    albumDecodeMicros = micros() - started;
+    log_i("album image pushed %uus after it started decoding", albumDecodeMicros);
+  }
 }
 
 void drawNowPlayingOrSeek() {
+  RenderTimer timer(NowPlayingOrSeekTiming);
   const auto now = millis();
   tft.setCursor(0, lineOne);
   if (statusMessage[0] != '\0') {
@@ -1463,25 +1767,25 @@ void drawNowPlayingOrSeek() {
     const int width = ICON_SIZE + 2;
     const int extraSpace = 10;
 
-    bool likeClicked = menuIndex == LikeButton && spotifyActionIsQueued(ToggleLike) && now <= clickEffectEndMillis;
+    bool likeClicked = menuIndex == LikeButton && spotifyActionIsQueued(ToggleLike) && animationTimeline.running(ClickEffectAnimation);
     tft.setCursor(5, iconTop);
     drawIcon(spotifyState.isLiked ? ICON_FAVORITE : ICON_FAVORITE_OUTLINE, menuIndex == LikeButton, likeClicked,
-            spotifyState.trackId[0] == '\0' && (spotifyAction != Previous && spotifyAction != Next));
+            spotifyState.trackId.isEmpty() && (spotifyAction != Previous && spotifyAction != Next));
 
     tft.setCursor(screenWidth / 2 - ICON_SIZE / 2 - ICON_SIZE * 2 - 3 - extraSpace, iconTop);
     drawIcon(ICON_SHUFFLE, menuIndex == ShuffleButton, false, spotifyState.disallowsTogglingShuffle, spotifyState.isShuffled);
 
-    bool backClicked = menuIndex == BackButton && (spotifyActionIsQueued(Previous) || (spotifyActionIsQueued(Seek) && spotifySeekToMillis == 0)) && now <= clickEffectEndMillis;
+    bool backClicked = menuIndex == BackButton && (spotifyActionIsQueued(Previous) || (spotifyActionIsQueued(Seek) && spotifySeekToMillis == 0)) && animationTimeline.running(ClickEffectAnimation);
     tft.setCursor(tft.getCursorX() + width + extraSpace + 1, iconTop);
     drawIcon(ICON_SKIP_PREVIOUS, menuIndex == BackButton, backClicked, spotifyState.disallowsSkippingPrev);
 
     bool playingOrTrying = spotifyState.isPlaying || (spotifyPlayUri[0] != '\0' && spotifyPlayAtMillis >= 0);
     const String& playPauseIcon = playingOrTrying ? ICON_PAUSE : ICON_PLAY_ARROW;
-    bool playPauseClicked = menuIndex == PlayPauseButton && spotifyActionIsQueued(Toggle) && now <= clickEffectEndMillis;
+    bool playPauseClicked = menuIndex == PlayPauseButton && spotifyActionIsQueued(Toggle) && animationTimeline.running(ClickEffectAnimation);
     tft.setCursor(tft.getCursorX() + width, iconTop);
     drawIcon(playPauseIcon, menuIndex == PlayPauseButton, playPauseClicked);
 
-    bool nextClicked = menuIndex == NextButton && spotifyActionIsQueued(Next) && now <= clickEffectEndMillis;
+    bool nextClicked = menuIndex == NextButton && spotifyActionIsQueued(Next) && animationTimeline.running(ClickEffectAnimation);
     tft.setCursor(tft.getCursorX() + width, iconTop);
     drawIcon(ICON_SKIP_NEXT, menuIndex == NextButton, nextClicked, spotifyState.disallowsSkippingNext);
 
@@ -1510,11 +1814,8 @@ void drawNowPlayingOrSeek() {
     drawIcon(volumeIcon, menuIndex == VolumeButton, false, activeSpotifyDevice == nullptr);
   }
 
-  if (!shouldShowProgressBar()) {
-    const int seekRadius = 4;
-    const bool seekSelected = menuMode == SeekControl || menuIndex == SeekButton;
-    img.createSprite(dividerWidth + seekRadius * 2, seekRadius * 2 + 1);
-    img.fillSprite(TFT_BLACK);
+  const bool seekSelected = menuMode == SeekControl || menuIndex == SeekButton;
+  if (!shouldShowProgressBar() && spriteArena.borrow(img, dividerWidth + seekRadius * 2, seekRadius * 2 + 1)) {
     img.drawFastHLine(seekRadius, seekRadius, dividerWidth, seekSelected ? TFT_DARKERGREY : TFT_LIGHTBLACK);
     if (seekSelected) img.drawFastHLine(seekRadius, seekRadius - 1, dividerWidth, TFT_DARKERGREY);
     if (spotifyState.estimatedProgressMillis > 0 && spotifyState.durationMillis > 0) {
@@ -1527,14 +1828,14 @@ void drawNowPlayingOrSeek() {
         img.fillCircle(seekRadius + round(dividerWidth * progress), seekRadius, 2, TFT_BLACK);
       }
     }
-    img.pushSprite(6 - seekRadius, lineDivider - seekRadius);
-    img.deleteSprite();
+    spriteArena.push(img, 6 - seekRadius, lineDivider - seekRadius);
+    spriteArena.giveBack(img);
   }
 
   if (millis() - nowPlayingDisplayMillis >= 50) {
     const bool isGenrePlaylist = playingGenreIndex >= 0;
     if (isGenrePlaylist) {
-      img.setTextColor(genreColors[playingGenreIndex], TFT_BLACK);
+      img.setTextColor(genreCatalog.genreColor(playingGenreIndex), TFT_BLACK);
     } else {
       img.setTextColor(TFT_DARKGREY, TFT_BLACK);
     }
@@ -1557,16 +1858,16 @@ void drawNowPlayingOrSeek() {
       if (spotifyState.contextName[0] != '\0') texts.push_back(spotifyState.contextName);
 
       auto textIndex = spotifyState.estimatedProgressMillis / 4000 % texts.size();
-      if (spotifyState.albumName[0] != '\0' && texts[textIndex] == spotifyState.albumName && !spotifyImage.isEmpty()) {
+      if (spotifyState.albumName[0] != '\0' && texts[textIndex] == spotifyState.albumName && albumImageAvailable()) {
         if (displayInvalidatedPartial && !spotifyImageDrawn) tft.fillRect(textStartX, albumY, textWidth, screenHeight - albumY, TFT_BLACK);
         drawAlbumImage();
-        drawCenteredText(texts[textIndex].c_str(), textWidth - albumSize - textPadding, maxTextLines);
+        drawNowPlayingText(texts[textIndex].c_str(), textWidth - albumSize - textPadding);
       } else {
         if (displayInvalidatedPartial && spotifyImageDrawn) {
           tft.fillRect(albumX, albumY, albumSize, albumSize, TFT_BLACK);
           spotifyImageDrawn = false;
         }
-        drawCenteredText(texts[textIndex].c_str(), textWidth, maxTextLines);
+        drawNowPlayingText(texts[textIndex].c_str(), textWidth);
       }
     } else {
       img.setTextColor(TFT_LIGHTBLACK, TFT_BLACK);
@@ -1582,6 +1883,7 @@ void drawNowPlayingOrSeek() {
         if (displayInvalidatedPartial) tft.fillRect(albumX, albumY, albumSize, albumSize, TFT_BLACK);
         spotifyImageDrawn = false;
       }
+      stopMarquee();
       if (text) drawCenteredText(text, textWidth, maxTextLines);
     }
 
@@ -1589,16 +1891,42 @@ void drawNowPlayingOrSeek() {
   }
 }
 
+void drawNowPlayingText(const char *text, uint16_t maxWidth) {
+  // wrapped lines don't fill all the way, so anything close to all of them would be cut off
+  const bool wouldTruncate = marquee.textWidth(text) * 8 > maxWidth * maxTextLines * 7;
+  const auto now = millis();
+  if (!wouldTruncate ||
+      !marquee.start(text, img.textcolor, img.textbgcolor, tft.getCursorX(), tft.getCursorY(), maxWidth, now)) {
+    stopMarquee();
+    drawCenteredText(text, maxWidth, maxTextLines);
+    return;
+  }
+
+  if (!animationTimeline.running(MarqueeAnimation)) animationTimeline.start(MarqueeAnimation, now);
+  marquee.draw(tft, now);
+  const uint16_t lineHeight = img.gFont.yAdvance + lineSpacing;
+  tft.fillRect(tft.getCursorX(), tft.getCursorY() + lineHeight, maxWidth, lineHeight * (maxTextLines - 1), TFT_BLACK);
+}
+
+void stopMarquee() {
+  animationTimeline.stop(MarqueeAnimation);
+  marquee.stop();
+}
+
 void drawPlaylistsMenu() {
+  RenderTimer timer(PlaylistsMenuTiming);
   const char *text = menuText;
+  uint32_t textLayout = 0;
   bool selected = playingGenreIndex == genreIndex;
   char selectedUri[sizeof(SpotifyState_t::contextUri)];
 
   if (menuMode == GenreList) {
-    text = genres[genreIndex];
+    text = genreCatalog.genreName(genreIndex, menuText, sizeof(menuText));
+    textLayout = genreCatalog.genreTextLayout(genreIndex);
   } else if (menuMode == CountryList) {
     selected = playingCountryIndex == menuIndex;
-    text = countries[countryIndex];
+    text = genreCatalog.countryName(countryIndex);
+    textLayout = genreCatalog.countryTextLayout(countryIndex);
   } else if (menuMode == PlaylistList) {
     if (!spotifyPlaylistsLoaded) {
       text = "loading...";
@@ -1627,14 +1955,34 @@ void drawPlaylistsMenu() {
 
   img.setTextColor(selected ? TFT_LIGHTGREY : TFT_DARKGREY, TFT_BLACK);
   if (menuMode == GenreList || (menuMode == ExploreList && exploreMenuItems[menuIndex].type == ExploreItemPlaylist)) {
-    img.setTextColor(genreColors[genreIndex], TFT_BLACK);
+    img.setTextColor(genreCatalog.genreColor(genreIndex), TFT_BLACK);
   }
 
   tft.setCursor(textStartX, lineTwo);
-  drawCenteredText(text, textWidth, maxTextLines);
+  drawCenteredText(text, textWidth, maxTextLines, textLayout);
+}
+
+void drawRenderStats() {
+  const uint16_t lineHeight = img.gFont.yAdvance + lineSpacing;
+  char stats[24];
+  snprintf(stats, sizeof(stats), "%u fps %.1f ms", renderProfiler.fps(millis()),
+           frameScheduler.lastFrameMicros() / 1000.0);
+  if (!spriteArena.borrow(img, renderStatsWidth, lineHeight)) return;
+  img.setTextColor(TFT_GREEN, TFT_BLACK);
+  img.setCursor(0, 0);
+  img.printToSprite(stats, strlen(stats));
+  spriteArena.push(img, 0, screenHeight - lineHeight);
+  spriteArena.giveBack(img);
+
+  const unsigned long now = millis();
+  if (now - lastRenderStatsPrintMillis >= renderStatsPrintMillis) {
+    lastRenderStatsPrintMillis = now;
+    renderProfiler.print(Serial);
+  }
 }
 
 void drawStatusOverlay() {
+  RenderTimer timer(StatusOverlayTiming);
   auto batteryY = screenHeight - 44;
   bool charging = knobby.powerStatus() == PowerStatusPowered;
   #ifdef LILYGO_WATCH_2019_WITH_TOUCH
@@ -1644,12 +1992,47 @@ void drawStatusOverlay() {
   #endif
 }
 
+// the catalog may have changed size since these were saved, or been swapped for the built-in one
+void clampCatalogIndexes() {
+  if (genreIndex >= genreCatalog.genreCount()) genreIndex = random(genreCatalog.genreCount());
+  if (countryIndex >= genreCatalog.countryCount()) countryIndex = random(genreCatalog.countryCount());
+  if (playingGenreIndex >= genreCatalog.genreCount()) playingGenreIndex = -1;
+  if (playingCountryIndex >= genreCatalog.countryCount()) playingCountryIndex = -1;
+  if (explorePlaylistsGenreIndex >= genreCatalog.genreCount()) {
+    explorePlaylistsGenreIndex = -1;
+    explorePlaylists.clear();
+  }
+}
+
+// runs on the loop while the background task is between actions, so neither is still reading the partition
+void swapToBuiltInCatalog() {
+  if (xSemaphoreTake(backgroundApiLock, 0) != pdTRUE) return;
+  genreCatalog.useBuiltIn();
+  genreCatalog.useTextLayouts(textWidth, img.gFont.spaceWidth);
+  clampCatalogIndexes();
+  catalogSwapRequested = false;
+  xSemaphoreGive(backgroundApiLock);
+
+  if (menuMode == GenreList) {
+    setMenuMode(GenreList, getMenuIndexForGenreIndex(genreIndex));
+  } else if (menuMode == CountryList) {
+    setMenuMode(CountryList, countryIndex);
+  } else if (menuMode == ExploreList) {
+    setMenuMode(NowPlaying, 0);
+  } else {
+    invalidateDisplay(true);
+  }
+}
+
 void invalidateDisplay(bool eraseDisplay) {
+  frameScheduler.invalidated(displayInvalidated);
   displayInvalidated = true;
   displayInvalidatedPartial = displayInvalidatedPartial && !eraseDisplay;
 }
 
 void updateDisplay() {
+  RenderTimer timer(UpdateDisplayTiming);
+  frameScheduler.beginFrame();
   unsigned long now = millis();
   if (!displayInvalidatedPartial) tft.fillScreen(TFT_BLACK);
   img.setTextColor(TFT_DARKGREY, TFT_BLACK);
@@ -1675,16 +2058,64 @@ void updateDisplay() {
     drawPlaylistsMenu();
   }
   drawStatusOverlay();
+  tft.flushShadow();
   displayInvalidated = false;
   displayInvalidatedPartial = true;
   lastDisplayMillis = millis();
+  frameScheduler.endFrame();
+  renderProfiler.frameDrawn(lastDisplayMillis);
 }
 
-void drawCenteredText(const char *text, uint16_t maxWidth, uint16_t maxLines) {
+void drawCenteredText(const char *text, uint16_t maxWidth, uint16_t maxLines, uint32_t layout) {
+  RenderTimer timer(CenteredTextTiming);
+  const uint16_t lineHeight = img.gFont.yAdvance + lineSpacing;
+  const TextLineKey_t key = textLineCache.key(text, img.textcolor, img.textbgcolor, maxWidth, maxLines);
+  uint16_t lineNumber = textLineCache.draw(tft, key, tft.getCursorX(), tft.getCursorY());
+  if (lineNumber > 0) {
+    tft.setCursor(tft.getCursorX(), tft.getCursorY() + lineHeight * lineNumber);
+  } else {
+    lineNumber = renderCenteredText(text, key, layout, true);
+  }
+
+  while (lineNumber < maxLines) {
+    tft.fillRect(tft.getCursorX(), tft.getCursorY(), maxWidth, lineHeight, TFT_BLACK);
+    tft.setCursor(tft.getCursorX(), tft.getCursorY() + lineHeight);
+    lineNumber++;
+  }
+}
+
+void finishTextLine(const TextLineKey_t &key, uint16_t lineNumber, bool draw) {
+  textLineCache.store(key, lineNumber, (uint16_t *)img.getPointer(), img.width());
+  if (!draw) return;
+  spriteArena.push(img, tft.getCursorX(), tft.getCursorY());
+  tft.setCursor(tft.getCursorX(), tft.getCursorY() + img.gFont.yAdvance + lineSpacing);
+}
+
+uint16_t renderCenteredText(const char *text, const TextLineKey_t &key, uint32_t layout, bool draw) {
+  const uint16_t maxWidth = key.maxWidth;
+  const uint16_t maxLines = key.maxLines;
   const uint16_t lineHeight = img.gFont.yAdvance + lineSpacing;
   const uint16_t centerX = floor(maxWidth / 2.0);
   const uint16_t len = strlen(text);
 
+  if (layout != 0 && maxLines >= 2) {
+    // line breaks and widths were already worked out by load_genres.rb
+    const uint16_t lineStarts[] = {0, textLayoutBreak(layout), len};
+    uint16_t lineNumber = 0;
+    // the lines are left blank when there's no sprite to draw them in
+    if (!spriteArena.borrow(img, maxWidth, lineHeight)) return 0;
+    for (; lineNumber < 2 && lineStarts[lineNumber] < len; lineNumber++) {
+      const uint16_t lineWidth = textLayoutWidth(layout, lineNumber);
+      if (lineNumber > 0 || img.textbgcolor != TFT_BLACK) spriteArena.clear(img, img.textbgcolor);
+      img.setCursor(centerX - floor(lineWidth / 2.0), 0);
+      img.printToSprite((char *)&text[lineStarts[lineNumber]], lineStarts[lineNumber + 1] - lineStarts[lineNumber]);
+      finishTextLine(key, lineNumber, draw);
+    }
+    spriteArena.giveBack(img);
+    textLineCache.complete(key, lineNumber);
+    return lineNumber;
+  }
+
   uint16_t lineNumber = 0;
   uint16_t pos = 0;
   int16_t totalWidth = 0;
@@ -1694,15 +2125,15 @@ void drawCenteredText(const char *text, uint16_t maxWidth, uint16_t maxLines) {
   bool breakpointOnSpace = false;
   uint16_t lastDrawnPos = 0;
 
-  img.createSprite(maxWidth, lineHeight);
-  img.fillSprite(TFT_BLACK);
+  if (!spriteArena.borrow(img, maxWidth, lineHeight)) return 0;
+  if (img.textbgcolor != TFT_BLACK) spriteArena.clear(img, img.textbgcolor);
 
   while (pos < len) {
     uint16_t lastPos = pos;
     uint16_t unicode = img.decodeUTF8((uint8_t *)text, &pos, len - pos);
     int16_t width = 0;
 
-    if (img.getUnicodeIndex(unicode, &index)) {
+    if (img.glyphIndex(unicode, &index)) {
       if (pos == 0) width = -img.gdX[index];
       if (pos == len - 1) {
         width = (img.gWidth[index] + img.gdX[index]);
@@ -1739,8 +2170,7 @@ void drawCenteredText(const char *text, uint16_t maxWidth, uint16_t maxLines) {
 
       img.setCursor(centerX - floor(lineWidth / 2.0), 0);
       img.printToSprite(line, lineLength);
-      img.pushSprite(tft.getCursorX(), tft.getCursorY());
-      tft.setCursor(tft.getCursorX(), tft.getCursorY() + lineHeight);
+      finishTextLine(key, lineNumber, draw);
 
       lastDrawnPos = preferredBreakpoint;
       // It is possible that we did not draw all letters to n so we need
@@ -1751,7 +2181,7 @@ void drawCenteredText(const char *text, uint16_t maxWidth, uint16_t maxLines) {
       preferredBreakpoint = 0;
       lineNumber++;
       if (lineNumber >= maxLines) break;
-      img.fillSprite(TFT_BLACK);
+      spriteArena.clear(img, img.textbgcolor);
     }
   }
 
@@ -1762,53 +2192,113 @@ void drawCenteredText(const char *text, uint16_t maxWidth, uint16_t maxLines) {
     strncpy(line, &text[lastDrawnPos], lineLength);
     img.setCursor(centerX - floor(totalWidth / 2.0), 0);
     img.printToSprite(line, lineLength);
-    img.pushSprite(tft.getCursorX(), tft.getCursorY());
-    tft.setCursor(tft.getCursorX(), tft.getCursorY() + lineHeight);
+    finishTextLine(key, lineNumber, draw);
     lineNumber++;
   }
 
-  img.deleteSprite();
+  spriteArena.giveBack(img);
+  textLineCache.complete(key, lineNumber);
+  return lineNumber;
+}
 
-  while (lineNumber < maxLines) {
-    tft.fillRect(tft.getCursorX(), tft.getCursorY(), maxWidth, lineHeight, TFT_BLACK);
-    tft.setCursor(tft.getCursorX(), tft.getCursorY() + lineHeight);
-    lineNumber++;
+// the id following prefix in a uri like spotify:playlist:id, or an empty id if it doesn't match
+SpotifyId getSpotifyIdFromUri(const char *uri, const char *prefix) {
+  const auto prefixLength = strlen(prefix);
+  if (!uri || strncmp(uri, prefix, prefixLength) != 0 || strlen(uri + prefixLength) != SPOTIFY_ID_SIZE) {
+    return SpotifyId();
   }
+  return SpotifyId::decode(uri + prefixLength);
 }
 
-bool onJpgBlockDecoded(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t *bitmap) {
-  if (y >= tft.height()) return 0;
-  while(jpgRenderReady) yield();
-  memcpy(jpgBlockBuffer, bitmap, 16 * 16 * 2);
-  jpgBlockX = x;
-  jpgBlockY = y;
-  jpgBlockW = w;
-  jpgBlockH = h;
-  jpgRenderReady = true;
-  return 1;
+const SpotifyId &getPlaylistId(PlaylistSources source, uint16_t index) {
+  static const SpotifyId emptyId;
+  switch (source) {
+    case PlaylistSourceGenre:
+      return genreCatalog.genrePlaylist(index);
+    case PlaylistSourceCountry:
+      return genreCatalog.countryPlaylist(index);
+    case PlaylistSourceUser:
+      return spotifyPlaylists[index].id;
+    case PlaylistSourceExplore:
+      return explorePlaylists[index].id;
+    default:
+      return emptyId;
+  }
 }
 
-void jpgDecodeLoop(void *params) {
-  for(;;) {
-    if (jpgDecodeReady) {
-      auto start = millis();
-      JRESULT result = TJpgDec.drawJpg(0, 0, (uint8_t *)spotifyImage.c_str(), spotifyImage.length());
-      jpgDecodeReady = false;
-      if (result == JDR_OK) {
-        log_i("decoded jpg in %dms", millis() - start);
-      } else {
-        log_e("error %d decoding jpg", result);
-      }
+// genre and country playlists use the perfect hash generated by load_genres.rb
+PlaylistEntity_t findCatalogPlaylist(const SpotifyId &id) {
+  PlaylistEntity_t playlist;
+  const int entity = genreCatalog.findPlaylist(id);
+  if (entity < 0) {
+    return playlist;
+  } else if (entity < genreCatalog.genreCount()) {
+    playlist.source = PlaylistSourceGenre;
+    playlist.index = entity;
+  } else {
+    playlist.source = PlaylistSourceCountry;
+    playlist.index = entity - genreCatalog.genreCount();
+  }
+  return playlist;
+}
+
+// user and explore playlists are kept in an open addressed table, rebuilt when either list changes
+void updatePlaylistIndex() {
+  size_t capacity = 16;
+  while (capacity < (spotifyPlaylists.size() + explorePlaylists.size()) * 2) capacity *= 2;
+  std::vector<PlaylistIndexSlot_t> slots(capacity);
+
+  auto insert = [&slots, capacity](PlaylistSources source, uint16_t index) {
+    const uint32_t hash = getPlaylistId(source, index).hash();
+    auto slot = hash & (capacity - 1);
+    while (slots[slot].source != PlaylistSourceNone) slot = (slot + 1) & (capacity - 1);
+    slots[slot].hash = hash;
+    slots[slot].index = index;
+    slots[slot].source = source;
+  };
+  for (auto i = 0; i < spotifyPlaylists.size(); i++) insert(PlaylistSourceUser, i);
+  for (auto i = 0; i < explorePlaylists.size(); i++) insert(PlaylistSourceExplore, i);
+
+  // built on the background task, so only swap the finished table in while the loop isn't probing it
+  xSemaphoreTake(playlistIndexLock, portMAX_DELAY);
+  playlistIndexSlots.swap(slots);
+  xSemaphoreGive(playlistIndexLock);
+}
+
+PlaylistEntity_t findIndexedPlaylist(const SpotifyId &id, PlaylistSources source) {
+  PlaylistEntity_t playlist;
+  if (id.isEmpty()) return playlist;
+  const uint32_t hash = id.hash();
+
+  xSemaphoreTake(playlistIndexLock, portMAX_DELAY);
+  const size_t capacity = playlistIndexSlots.size();
+  for (auto slot = hash & (capacity - 1); capacity > 0 && playlistIndexSlots[slot].source != PlaylistSourceNone;
+       slot = (slot + 1) & (capacity - 1)) {
+    const auto &entry = playlistIndexSlots[slot];
+    if (entry.hash == hash && (source == PlaylistSourceNone || entry.source == source) &&
+        getPlaylistId(entry.source, entry.index) == id) {
+      playlist.source = entry.source;
+      playlist.index = entry.index;
+      break;
     }
-    yield();
   }
+  xSemaphoreGive(playlistIndexLock);
+  return playlist;
 }
 
-int indexOfId(const char *ids[], int count, const char *string) {
-  for (auto i = 0; i < count; i++) {
-    if (strcmp(string, ids[i]) == 0) return i;
+int findPlaylistIndex(const SpotifyId &id, PlaylistSources source) {
+  if (source == PlaylistSourceGenre || source == PlaylistSourceCountry) {
+    auto playlist = findCatalogPlaylist(id);
+    return playlist.source == source ? playlist.index : -1;
   }
-  return -1;
+  return findIndexedPlaylist(id, source).index;
+}
+
+// find a playlist by id, preferring genres and countries, then user playlists, then explore playlists
+PlaylistEntity_t findPlaylist(const SpotifyId &id) {
+  PlaylistEntity_t playlist = findCatalogPlaylist(id);
+  if (playlist.source != PlaylistSourceNone) return playlist;
+  return findIndexedPlaylist(id, PlaylistSourceNone);
 }
 
 // is genreIndex tracked in this menu?
@@ -1848,7 +2338,7 @@ bool shouldShowRandom() {
 }
 
 bool shouldShowExploreMenu() {
-  return (lastMenuMode == ExploreList || isGenreMenu(lastMenuMode) || playingGenreIndex >= 0 || spotifyState.artists[0].id[0] != '\0') && spotifyRefreshToken[0] != '\0';
+  return (lastMenuMode == ExploreList || isGenreMenu(lastMenuMode) || playingGenreIndex >= 0 || !spotifyState.artists[0].id.isEmpty()) && spotifyRefreshToken[0] != '\0';
 }
 
 bool shouldShowPlaylistsMenu() {
@@ -1885,9 +2375,9 @@ uint16_t checkMenuSize(MenuModes mode) {
     case PlaylistList:
       return spotifyPlaylists.size() + 1; // for virtual liked songs playlist
     case CountryList:
-      return COUNTRY_COUNT;
+      return genreCatalog.countryCount();
     case GenreList:
-      return GENRE_COUNT;
+      return genreCatalog.genreCount();
     case ExploreList:
       return exploreMenuItems.size();
     case SeekControl:
@@ -1905,21 +2395,16 @@ uint16_t checkMenuSize(MenuModes mode) {
 int getGenreIndexForMenuIndex(uint16_t index, MenuModes mode) {
   int foundGenre = -1;
   switch (mode) {
-    case GenreList:
-      switch (genreSort) {
-        case AlphabeticSort:
-          return index;
-        case AlphabeticSuffixSort:
-          return genreIndexes_suffix[index];
-        default:
-          return index;
-      }
+    case GenreList: {
+      auto indexes = genreCatalog.genreIndexes(genreSort);
+      return indexes ? indexes[index] : index;
+    }
     case PlaylistList:
-      return indexOfId(genrePlaylists, GENRE_COUNT, spotifyPlaylists[index].id);
+      return findPlaylistIndex(spotifyPlaylists[index].id, PlaylistSourceGenre);
     case ExploreList:
       switch (exploreMenuItems[index].type) {
         case ExploreItemPlaylist:
-          foundGenre = indexOfId(genrePlaylists, GENRE_COUNT, exploreMenuItems[index].id);
+          foundGenre = findPlaylistIndex(exploreMenuItems[index].id, PlaylistSourceGenre);
           return foundGenre >= 0 ? foundGenre : explorePlaylistsGenreIndex;
         default:
           return -1;
@@ -1929,45 +2414,76 @@ int getGenreIndexForMenuIndex(uint16_t index, MenuModes mode) {
   }
 }
 
-uint16_t getIndexOfGenreIndex(const uint16_t indexes[], uint16_t indexToFind) {
-  for (uint16_t i = 0; i < GENRE_COUNT; i++) {
-    if (indexes[i] == indexToFind) return i;
-  }
-  return 0;
-}
-
 uint16_t getMenuIndexForGenreIndex(uint16_t index) {
-  switch (genreSort) {
-    case AlphabeticSort:
-      return index;
-    case AlphabeticSuffixSort:
-      return getIndexOfGenreIndex(genreIndexes_suffix, index);
-    default:
-      return index;
-  }
+  auto menuIndexes = genreCatalog.genreMenuIndexes(genreSort);
+  return menuIndexes ? menuIndexes[index] : index;
 }
 
 int getMenuIndexForPlaylist(const char *contextUri) {
   if (!contextUri) return -1;
-  auto size = checkMenuSize(PlaylistList);
-  char uri[sizeof(SpotifyState_t::contextUri)];
-  for (auto i = 0; i < size; i++) {
-    getContextUri(uri, PlaylistList, i);
-    if (strcmp(uri, spotifyState.contextUri) == 0) {
-      return i;
-    }
+  if (strncmp(contextUri, spotifyPlaylistContextPrefix, sizeof(spotifyPlaylistContextPrefix) - 1) == 0) {
+    auto playlistIndex = findPlaylistIndex(getSpotifyIdFromUri(contextUri, spotifyPlaylistContextPrefix), PlaylistSourceUser);
+    return playlistIndex < 0 ? -1 : playlistIndex + 1;
+  } else if (activeSpotifyUser) {
+    char likedSongsUri[sizeof(SpotifyState_t::contextUri)];
+    getContextUri(likedSongsUri, PlaylistList, 0);
+    if (strcmp(contextUri, likedSongsUri) == 0) return 0;
   }
   return -1;
 }
 
+void prefetchMenuNeighbors() {
+  if (menuMode != prefetchedMenuMode || menuIndex != prefetchedMenuIndex) {
+    prefetchedMenuMode = menuMode;
+    prefetchedMenuIndex = menuIndex;
+    prefetchedMenuNeighbors = 0;
+  }
+  // neighbors rendered ahead of time are only kept in the text line cache, and only worth rendering if it has room
+  // for them next to the line on screen instead of evicting it
+  if (!textLineCache.fits(3)) return;
+  if (menuSize < 2 || (menuMode == PlaylistList && !spotifyPlaylistsLoaded)) return;
+  if (menuMode != GenreList && menuMode != CountryList && menuMode != PlaylistList) return;
+
+  // one item per loop, so turning the knob again isn't held up by more than one line of rendering
+  while (prefetchedMenuNeighbors < 2) {
+    const uint16_t index = (menuIndex + (prefetchedMenuNeighbors++ == 0 ? 1 : menuSize - 1)) % menuSize;
+    const char *text = menuText;
+    uint32_t textLayout = 0;
+    uint32_t color = TFT_DARKGREY;
+    char neighborText[sizeof(menuText)] = "";
+    if (menuMode == GenreList) {
+      const int genre = getGenreIndexForMenuIndex(index, menuMode);
+      text = genreCatalog.genreName(genre, neighborText, sizeof(neighborText));
+      textLayout = genreCatalog.genreTextLayout(genre);
+      color = genreCatalog.genreColor(genre);
+    } else if (menuMode == CountryList) {
+      text = genreCatalog.countryName(index);
+      textLayout = genreCatalog.countryTextLayout(index);
+      if (playingCountryIndex == index) color = TFT_LIGHTGREY;
+    } else {
+      char uri[sizeof(SpotifyState_t::contextUri)];
+      getMenuText(neighborText, menuMode, index);
+      getContextUri(uri, menuMode, index);
+      text = neighborText;
+      if (strcmp(spotifyState.contextUri, uri) == 0) color = TFT_LIGHTGREY;
+    }
+
+    const TextLineKey_t key = textLineCache.key(text, color, TFT_BLACK, textWidth, maxTextLines);
+    if (textLineCache.cached(key)) continue;
+    img.setTextColor(color, TFT_BLACK);
+    renderCenteredText(text, key, textLayout, false);
+    return;
+  }
+}
+
 void getMenuText(char *name, MenuModes mode, uint16_t index) {
   const auto maxLength = sizeof(menuText) - 1;
   switch (mode) {
     case GenreList:
-      strncpy(name, genres[getGenreIndexForMenuIndex(index, mode)], maxLength);
+      genreCatalog.genreName(getGenreIndexForMenuIndex(index, mode), name, maxLength + 1);
       break;
     case CountryList:
-      snprintf(name, maxLength, countries[index]);
+      strncpy(name, genreCatalog.countryName(index), maxLength);
       break;
     case PlaylistList:
       if (index == 0) {
@@ -1981,7 +2497,7 @@ void getMenuText(char *name, MenuModes mode, uint16_t index) {
         strncpy(name, exploreMenuItems[index].name.c_str(), maxLength);
       } else {
         auto genre = getGenreIndexForMenuIndex(index, mode);
-        if (genre >= 0 && genre < GENRE_COUNT) strncpy(name, genres[genre], maxLength);
+        if (genre >= 0 && genre < genreCatalog.genreCount()) genreCatalog.genreName(genre, name, maxLength + 1);
       }
       break;
     default:
@@ -1994,33 +2510,24 @@ void getContextName(char *name, const char *contextUri) {
   if (uri.startsWith("spotify:user:") && uri.endsWith(":collection")) {
     strcpy(name, "Liked Songs");
   } else if (uri.startsWith(spotifyPlaylistContextPrefix)) {
-    auto id = uri.substring(sizeof(spotifyPlaylistContextPrefix) - 1).c_str();
-    auto playlistCountryIndex = indexOfId(countryPlaylists, COUNTRY_COUNT, id);
-    auto playlistGenreIndex = indexOfId(genrePlaylists, GENRE_COUNT, id);
-    if (playlistCountryIndex >= 0) {
-      getMenuText(name, CountryList, playlistCountryIndex);
-    } else if (playlistGenreIndex >= 0) {
+    auto playlist = findPlaylist(getSpotifyIdFromUri(contextUri, spotifyPlaylistContextPrefix));
+    if (playlist.source == PlaylistSourceCountry) {
+      getMenuText(name, CountryList, playlist.index);
+    } else if (playlist.source == PlaylistSourceGenre) {
       auto oldGenreSort = genreSort;
       genreSort = AlphabeticSort;
-      getMenuText(name, GenreList, playlistGenreIndex);
+      getMenuText(name, GenreList, playlist.index);
       genreSort = oldGenreSort;
-    }
-    if (name[0] == '\0' && spotifyPlaylistsLoaded) {
-      auto playlistIndex = getMenuIndexForPlaylist(contextUri);
-      if (playlistIndex >= 0) getMenuText(name, PlaylistList, playlistIndex);
-    }
-    if (name[0] == '\0' && !explorePlaylists.empty()) {
-      auto playlist = std::find_if(explorePlaylists.begin(), explorePlaylists.end(), [id](const ExploreItem_t &item) {
-        return strcmp(item.id, id) == 0;
-      });
-      if (playlist != explorePlaylists.end()) {
-        getMenuText(name, ExploreList, playlist - explorePlaylists.begin());
-      }
+    } else if (playlist.source == PlaylistSourceUser) {
+      getMenuText(name, PlaylistList, playlist.index + 1);
+    } else if (playlist.source == PlaylistSourceExplore) {
+      strncpy(name, explorePlaylists[playlist.index].name.c_str(), sizeof(SpotifyState_t::contextName) - 1);
     }
   } else if (uri.startsWith("spotify:artist:")) {
+    const auto artistId = getSpotifyIdFromUri(contextUri, "spotify:artist:");
     for (auto artist : spotifyState.artists) {
-      if (artist.id[0] == '\0') break;
-      if (uri.endsWith(artist.id)) {
+      if (artist.id.isEmpty()) break;
+      if (artist.id == artistId) {
         strncpy(name, artist.name, sizeof(SpotifyState_t::contextName) - 1);
         break;
       }
@@ -2033,27 +2540,32 @@ void getContextName(char *name, const char *contextUri) {
 void getContextUri(char *uri, MenuModes mode, uint16_t index) {
   const char *playlistUri = "spotify:playlist:%s";
   const auto uriSize = sizeof(SpotifyState_t::contextUri);
+  char id[SPOTIFY_ID_SIZE + 1] = "";
   switch (mode) {
     case GenreList:
-      snprintf(uri, uriSize, playlistUri, genrePlaylists[getGenreIndexForMenuIndex(index, mode)]);
+      genreCatalog.genrePlaylist(getGenreIndexForMenuIndex(index, mode)).encode(id);
+      snprintf(uri, uriSize, playlistUri, id);
       break;
     case CountryList:
-      snprintf(uri, uriSize, playlistUri, countryPlaylists[index]);
+      genreCatalog.countryPlaylist(index).encode(id);
+      snprintf(uri, uriSize, playlistUri, id);
       break;
     case PlaylistList:
       if (index == 0) {
         snprintf(uri, uriSize, "spotify:user:%s:collection", activeSpotifyUser->id);
       } else {
-        snprintf(uri, uriSize, playlistUri, spotifyPlaylists[index - 1].id);
+        spotifyPlaylists[index - 1].id.encode(id);
+        snprintf(uri, uriSize, playlistUri, id);
       }
       break;
     case ExploreList:
+      exploreMenuItems[index].id.encode(id);
       if (exploreMenuItems[index].type == ExploreItemPlaylist) {
-        snprintf(uri, uriSize, playlistUri, exploreMenuItems[index].id);
+        snprintf(uri, uriSize, playlistUri, id);
       } else if (exploreMenuItems[index].type == ExploreItemArtist) {
-        snprintf(uri, uriSize, "spotify:artist:%s", exploreMenuItems[index].id);
+        snprintf(uri, uriSize, "spotify:artist:%s", id);
       } else if (exploreMenuItems[index].type == ExploreItemAlbum) {
-        snprintf(uri, uriSize, "spotify:album:%s", exploreMenuItems[index].id);
+        snprintf(uri, uriSize, "spotify:album:%s", id);
       }
       break;
     default:
@@ -2081,7 +2593,7 @@ void setMenuIndex(uint16_t newMenuIndex) {
       break;
     case ExploreList:
       if (exploreMenuItems[menuIndex].type == ExploreItemPlaylist) {
-        newGenreIndex = indexOfId(genrePlaylists, GENRE_COUNT, exploreMenuItems[menuIndex].id);
+        newGenreIndex = findPlaylistIndex(exploreMenuItems[menuIndex].id, PlaylistSourceGenre);
         if (newGenreIndex >= 0) genreIndex = newGenreIndex;
         else if (explorePlaylistsGenreIndex >= 0) genreIndex = explorePlaylistsGenreIndex;
       }
@@ -2095,6 +2607,7 @@ void setMenuIndex(uint16_t newMenuIndex) {
 void setMenuMode(MenuModes newMode, uint16_t newMenuIndex) {
   MenuModes oldMode = menuMode;
   menuMode = newMode;
+  if (newMode != NowPlaying && newMode != SeekControl) stopMarquee();
   menuSize = checkMenuSize(newMode);
   setMenuIndex(newMenuIndex);
   invalidateDisplay(oldMode != newMode);
@@ -2102,7 +2615,7 @@ void setMenuMode(MenuModes newMode, uint16_t newMenuIndex) {
 
 void setStatusMessage(const char *message, unsigned long durationMs) {
   strncpy(statusMessage, message, sizeof(statusMessage) - 1);
-  statusMessageUntilMillis = millis() + durationMs;
+  frameScheduler.scheduleWidget(StatusMessageWidget, millis() + durationMs);
   invalidateDisplay();
 }
 
@@ -2120,8 +2633,8 @@ void startDeepSleep() {
     digitalWrite(POWER_ON_PIN, LOW);
     esp_sleep_pd_config(ESP_PD_DOMAIN_RTC_PERIPH, ESP_PD_OPTION_ON);
   #endif
-  tft.writecommand(TFT_DISPOFF);
-  tft.writecommand(TFT_SLPIN);
+  tft.sendCommand(TFT_DISPOFF);
+  tft.sendCommand(TFT_SLPIN);
   struct timeval tod;
   gettimeofday(&tod, NULL);
   lastSleepSeconds = tod.tv_sec;
@@ -2143,6 +2656,7 @@ void startRandomizingMenu(bool autoplay) {
   if (now > randomizingMenuEndMillis) {
     randomizingMenuEndMillis = now + randomizingLengthMillis;
     randomizingMenuTicks = 1;
+    animationTimeline.start(RandomizingAnimation, now);
     randomizingMenuAutoplay = autoplay;
     if (randomizingMenuAutoplay) {
       spotifyResetProgress();
@@ -2240,10 +2754,12 @@ bool readDataJson() {
   if (doc.containsKey("configPassword")) knobby.setPassword(doc["configPassword"]);
   firmwareURL = doc["firmwareURL"] | defaultFirmwareURL;
   if (doc.containsKey("flipDisplay")) knobby.setFlippedDisplay(doc["flipDisplay"]);
+  randomByPopularity = doc["randomByPopularity"] | false;
   if (!doc["buttonPin"].isNull()) knobby.setButtonPin(doc["buttonPin"]);
   if (!doc["rotaryAPin"].isNull()) knobby.setRotaryAPin(doc["rotaryAPin"]);
   if (!doc["rotaryBPin"].isNull()) knobby.setRotaryBPin(doc["rotaryBPin"]);
   if (!doc["pulseCount"].isNull()) knobby.setPulseCount(doc["pulseCount"]);
+  frameScheduler.setMaxFps(doc["maxFps"] | FRAME_SCHEDULER_DEFAULT_FPS);
 
   JsonArray usersArray = doc["users"];
   spotifyUsers.clear();
@@ -2277,10 +2793,12 @@ bool writeDataJson() {
   doc["configPassword"] = knobby.password();
   if (!firmwareURL.isEmpty() && defaultFirmwareURL != firmwareURL) doc["firmwareURL"] = firmwareURL;
   if (knobby.flippedDisplay()) doc["flipDisplay"] = knobby.flippedDisplay();
+  if (randomByPopularity) doc["randomByPopularity"] = randomByPopularity;
   if (knobby.buttonPin() != ROTARY_ENCODER_BUTTON_PIN) doc["buttonPin"] = knobby.buttonPin();
   if (knobby.rotaryAPin() != ROTARY_ENCODER_A_PIN) doc["rotaryAPin"] = knobby.rotaryAPin();
   if (knobby.rotaryBPin() != ROTARY_ENCODER_B_PIN) doc["rotaryBPin"] = knobby.rotaryBPin();
   if (knobby.pulseCount() != ROTARY_ENCODER_PULSE_COUNT) doc["pulseCount"] = knobby.pulseCount();
+  if (frameScheduler.maxFps() != FRAME_SCHEDULER_DEFAULT_FPS) doc["maxFps"] = frameScheduler.maxFps();
 
   JsonArray usersArray = doc.createNestedArray("users");
 
@@ -2321,6 +2839,7 @@ void onOTAProgress(unsigned int progress, unsigned int total) {
   sprintf(status, "%u%%", (progress / (total / 100)));
   tft.setCursor(textStartX, lineTwo);
   drawCenteredText(status, textWidth, 1);
+  tft.flushShadow();
   ESP_ERROR_CHECK(esp_task_wdt_reset());
 }
 
@@ -2473,6 +2992,7 @@ void spotifyGetToken(const char *code, GrantTypes grant_type) {
       spotifyUsers.clear();
       writeDataJson();
       tft.fillScreen(TFT_BLACK);
+      tft.flushShadow();
       ESP.restart();
     }
     inactivityMillis = 15000;
@@ -2527,11 +3047,12 @@ void spotifyCurrentlyPlaying() {
       } else {
         strncpy(spotifyState.contextUri, contextUri.c_str(), sizeof(spotifyState.contextUri) - 1);
         if (context["type"].as<String>() == "playlist") {
-          const char *id = strrchr(spotifyState.contextUri, ':') + 1;
-          playingGenreIndex = indexOfId(genrePlaylists, GENRE_COUNT, id);
-          playingCountryIndex = indexOfId(countryPlaylists, COUNTRY_COUNT, id);
-          if (playingGenreIndex < 0 && playingCountryIndex < 0 && strcmp(spotifyGetPlaylistId, id) != 0) {
-            strncpy(spotifyGetPlaylistId, id, SPOTIFY_ID_SIZE);
+          const auto id = SpotifyId::decode(strrchr(spotifyState.contextUri, ':') + 1);
+          auto playlist = findPlaylist(id);
+          playingGenreIndex = playlist.source == PlaylistSourceGenre ? playlist.index : -1;
+          playingCountryIndex = playlist.source == PlaylistSourceCountry ? playlist.index : -1;
+          if (playingGenreIndex < 0 && playingCountryIndex < 0 && !id.isEmpty() && spotifyGetPlaylistId != id) {
+            spotifyGetPlaylistId = id;
             spotifyQueueAction(GetPlaylistInformation);
           }
         } else {
@@ -2546,15 +3067,15 @@ void spotifyCurrentlyPlaying() {
         emptyCurrentlyPlayingResponses = 0;
         spotifyState.durationMillis = item["duration_ms"];
 
-        const char *id = item["linked_from"]["id"] | item["id"];
-        if (spotifyState.lastUpdateMillis == 0 || strcmp(id, spotifyState.trackId) != 0) {
+        const auto id = SpotifyId::decode(item["linked_from"]["id"] | item["id"]);
+        if (spotifyState.lastUpdateMillis == 0 || id.isEmpty() || id != spotifyState.trackId) {
           if (menuMode == SeekControl) {
             menuSize = checkMenuSize(SeekControl);
             uint16_t newMenuIndex = spotifyState.progressMillis / 1000;
             if (newMenuIndex != menuIndex) setMenuIndex(newMenuIndex);
           }
 
-          strncpy(spotifyState.trackId, id, SPOTIFY_ID_SIZE);
+          spotifyState.trackId = id;
           strncpy(spotifyState.name, item["name"], sizeof(spotifyState.name) - 1);
 
           JsonArray artists = item["artists"];
@@ -2563,12 +3084,11 @@ void spotifyCurrentlyPlaying() {
           for (auto i = 0; i < (sizeof(spotifyState.artists) / sizeof(spotifyState.artists[0])); i++) {
             JsonObject artist = artists[i];
             if (artist.isNull()) {
-              spotifyState.artists[i].id[0] = '\0';
+              spotifyState.artists[i].id.clear();
               spotifyState.artists[i].name[0] = '\0';
             } else {
-              const char *artistId = artist["id"];
               const char *artistName = artist["name"];
-              strncpy(spotifyState.artists[i].id, artistId, SPOTIFY_ID_SIZE);
+              spotifyState.artists[i].id = SpotifyId::decode(artist["id"]);
               strncpy(spotifyState.artists[i].name, artistName, sizeof(SpotifyArtist_t::name) - 1);
 
               auto length = strlen(artistName);
@@ -2588,24 +3108,24 @@ void spotifyCurrentlyPlaying() {
 
           JsonObject album = item["album"];
           if (!album.isNull()) {
-            strncpy(spotifyState.albumId, album["id"], SPOTIFY_ID_SIZE);
+            spotifyState.albumId = SpotifyId::decode(album["id"]);
             strncpy(spotifyState.albumName, album["name"], sizeof(spotifyState.albumName) - 1);
 
             JsonArray images = album["images"];
             for (JsonObject image : images) {
               if (image["height"] == albumSize && image["width"] == albumSize &&
-                  (spotifyImage.isEmpty() || image["url"] != spotifyState.imageUrl)) {
+                  (!albumImageAvailable() || image["url"] != spotifyState.imageUrl)) {
                 strncpy(spotifyState.imageUrl, image["url"], sizeof(spotifyState.imageUrl) - 1);
-                spotifyImage.clear();
                 if (menuMode == NowPlaying) {
-                  spotifyQueueAction(GetImage);
+                  // an album seen recently is already decoded
+                  if (!albumImageAvailable()) spotifyQueueAction(GetImage);
                   invalidateDisplay(true);
                 }
                 break;
               }
             }
           } else {
-            spotifyState.albumId[0] = '\0';
+            spotifyState.albumId.clear();
             spotifyState.albumName[0] = '\0';
             spotifyState.imageUrl[0] = '\0';
           }
@@ -2688,6 +3208,7 @@ void spotifyCurrentlyPlaying() {
         spotifyPlaylists.clear();
         spotifyPlaylistsCount = 0;
         spotifyPlaylistsLoaded = false;
+        updatePlaylistIndex();
       }
     }
   } else if (statusCode >= 200 && statusCode < 300) {
@@ -2873,11 +3394,11 @@ void spotifyPlayPlaylist() {
 
 void spotifyResetProgress(bool keepContext) {
   spotifyState.name[0] = '\0';
-  spotifyState.artists[0].id[0] = '\0';
+  spotifyState.artists[0].id.clear();
   spotifyState.artists[0].name[0] = '\0';
-  spotifyState.albumId[0] = '\0';
+  spotifyState.albumId.clear();
   spotifyState.albumName[0] = '\0';
-  spotifyState.trackId[0] = '\0';
+  spotifyState.trackId.clear();
   spotifyState.imageUrl[0] = '\0';
   spotifyState.durationMillis = 0;
   spotifyState.progressMillis = 0;
@@ -2885,7 +3406,6 @@ void spotifyResetProgress(bool keepContext) {
   spotifyState.lastUpdateMillis = millis();
   spotifyState.isLiked = false;
   spotifyState.checkedLike = false;
-  spotifyImage.clear();
   nextCurrentlyPlayingMillis = millis() + SPOTIFY_WAIT_MILLIS;
   if (!spotifyState.isPrivateSession) spotifyState.isPlaying = false;
   if (!keepContext) {
@@ -2963,11 +3483,13 @@ void spotifySetVolume() {
 }
 
 void spotifyCheckLike() {
-  if (spotifyAccessToken[0] == '\0' || spotifyState.trackId[0] == '\0') return;
+  if (spotifyAccessToken[0] == '\0' || spotifyState.trackId.isEmpty()) return;
 
   int statusCode;
+  char trackId[SPOTIFY_ID_SIZE + 1];
+  spotifyState.trackId.encode(trackId);
   char path[46];
-  snprintf(path, sizeof(path), "me/tracks/contains?ids=%s", spotifyState.trackId);
+  snprintf(path, sizeof(path), "me/tracks/contains?ids=%s", trackId);
   statusCode = spotifyApiRequest("GET", path);
 
   if (statusCode == 200) {
@@ -2996,8 +3518,10 @@ void spotifyToggleLike() {
   invalidateDisplay();
 
   int statusCode;
+  char trackId[SPOTIFY_ID_SIZE + 1];
+  spotifyState.trackId.encode(trackId);
   char path[37];
-  snprintf(path, sizeof(path), "me/tracks?ids=%s", spotifyState.trackId);
+  snprintf(path, sizeof(path), "me/tracks?ids=%s", trackId);
   statusCode = spotifyApiRequest(spotifyState.isLiked ? "PUT" : "DELETE", path);
 
   if (statusCode > 204) {
@@ -3074,51 +3598,57 @@ void spotifyTransferPlayback() {
 };
 
 void spotifyGetPlaylistInformation() {
-  if (spotifyAccessToken[0] == '\0' || spotifyGetPlaylistId[0] == '\0') return;
+  if (spotifyAccessToken[0] == '\0' || spotifyGetPlaylistId.isEmpty()) return;
   int statusCode;
+  char playlistId[SPOTIFY_ID_SIZE + 1];
+  spotifyGetPlaylistId.encode(playlistId);
   char url[58];
-  snprintf(url, sizeof(url), "playlists/%s?fields=name,description", spotifyGetPlaylistId);
+  snprintf(url, sizeof(url), "playlists/%s?fields=name,description", playlistId);
   statusCode = spotifyApiRequest("GET", url);
 
   if (statusCode == 200) {
     DynamicJsonDocument json(3000);
     DeserializationError error = deserializeJson(json, spotifyHttp.getStream());
     if (!error) {
-      const String contextUri = spotifyState.contextUri;
-      if (contextUri.startsWith(spotifyPlaylistContextPrefix) && contextUri.endsWith(spotifyGetPlaylistId)) {
+      if (getSpotifyIdFromUri(spotifyState.contextUri, spotifyPlaylistContextPrefix) == spotifyGetPlaylistId) {
         strncpy(spotifyState.contextName, json["name"], sizeof(spotifyState.contextName) - 1);
       }
       explorePlaylists.clear();
+      updatePlaylistIndex();
       const auto prefixLength = sizeof(spotifyPlaylistContextPrefix) - 1;
       const String description = json["description"];
       int urlPosition = description.indexOf(spotifyPlaylistContextPrefix);
+      char exploreGenreName[GENRE_NAME_SIZE] = "";
+      if (explorePlaylistsGenreIndex >= 0) {
+        genreCatalog.genreName(explorePlaylistsGenreIndex, exploreGenreName, sizeof(exploreGenreName));
+      }
       while (urlPosition > 0) {
         ExploreItem_t item;
         item.type = ExploreItemPlaylist;
         int idStart = urlPosition + prefixLength;
         int idEnd = idStart + SPOTIFY_ID_SIZE;
-        strlcpy(item.id, description.c_str() + idStart, sizeof(item.id));
+        item.id = SpotifyId::decode(description.c_str() + idStart);
         int nameStart = description.indexOf(">", idEnd) + 1;
         int nameEnd = description.indexOf("<", nameStart);
         if (nameStart > 0 && nameEnd > 0) {
           String name = description.substring(nameStart, nameEnd);
-          int matchingGenreIndex = indexOfId(genrePlaylists, GENRE_COUNT, item.id);
+          int matchingGenreIndex = findPlaylistIndex(item.id, PlaylistSourceGenre);
           if (explorePlaylistsGenreIndex >= 0) {
             if (name == "Intro") {
               item.name.concat("an intro to ");
-              item.name.concat(genres[explorePlaylistsGenreIndex]);
+              item.name.concat(exploreGenreName);
             } else if (name == "Pulse" || name == "Edge") {
               name.toLowerCase();
               item.name.concat("the ");
               item.name.concat(name);
               item.name.concat(" of ");
-              item.name.concat(genres[explorePlaylistsGenreIndex]);
+              item.name.concat(exploreGenreName);
             } else if (name == "2023") {
               item.name.concat("2023 in ");
-              item.name.concat(genres[explorePlaylistsGenreIndex]);
+              item.name.concat(exploreGenreName);
             } else if (name == "\xE2\x99\x80""Filter") {
               item.name.concat("fem filter for ");
-              item.name.concat(genres[explorePlaylistsGenreIndex]);
+              item.name.concat(exploreGenreName);
             }
           }
           if (matchingGenreIndex < 0 && item.name.isEmpty()) item.name = name;
@@ -3128,6 +3658,7 @@ void spotifyGetPlaylistInformation() {
           urlPosition = description.indexOf(spotifyPlaylistContextPrefix, urlPosition + prefixLength);
         }
       }
+      updatePlaylistIndex();
       if (menuMode == ExploreList) {
         exploreMenuItems.insert(exploreMenuItems.end(), explorePlaylists.begin(), explorePlaylists.end());
         setMenuIndex(menuIndex);
@@ -3151,6 +3682,7 @@ void spotifyGetPlaylists() {
 
   spotifyPlaylists.clear();
   spotifyPlaylistsCount = 0;
+  updatePlaylistIndex();
 
   while (nextOffset >= 0) {
     snprintf(url, sizeof(url), "me/playlists/?fields=items(id,name),limit,offset,total&limit=%d&offset=%d", limit, nextOffset);
@@ -3174,13 +3706,14 @@ void spotifyGetPlaylists() {
           }
 
           SpotifyPlaylist_t playlist;
-          strncpy(playlist.id, id, SPOTIFY_ID_SIZE);
+          playlist.id = SpotifyId::decode(id);
           playlist.name = name;
           spotifyPlaylists.push_back(playlist);
         }
 
         items.clear();
         json.clear();
+        updatePlaylistIndex();
         spotifyPlaylistsLoaded = true;
         if (menuMode == PlaylistList) {
           menuSize = checkMenuSize(PlaylistList);
@@ -3208,7 +3741,12 @@ void spotifyGetPlaylists() {
 }
 
 void spotifyGetImage() {
-  if (spotifyState.imageUrl[0] == '\0') return;
+  if (spotifyState.imageUrl[0] == '\0' || albumImageAvailable()) return;
+  // new albums are also written to SPIFFS, so one from before the last sleep doesn't have to be downloaded again
+  if (albumArtCache.load(albumArtCache.key(spotifyState.imageUrl))) {
+    invalidateDisplay();
+    return;
+  }
 
   log_i("GET %s", spotifyState.imageUrl);
   spotifyWifiClient.stop();
@@ -3221,19 +3759,60 @@ void spotifyGetImage() {
   http.setTimeout(4000);
   http.setReuse(false);
   http.begin(client, spotifyState.imageUrl);
+  // the decoder reads the body straight off the connection, so it has to take chunks apart itself
+  const char *headers[] = {"Transfer-Encoding"};
+  http.collectHeaders(headers, 1);
   int code = http.GET();
   int contentLength = http.getSize();
+  const bool chunked = http.header("Transfer-Encoding").equalsIgnoreCase("chunked");
 
   if (code != 200) {
     log_e("HTTP code %d", code);
-  } else if (!spotifyImage.reserve(contentLength)) {
-    log_e("out of memory, need %d bytes", contentLength);
   } else {
-    http.writeToStream(&spotifyImage);
+    // decoded into a cache tile as it arrives, the main loop draws it from there
+    const uint32_t key = albumArtCache.key(spotifyState.imageUrl);
+    uint16_t *tile = albumArtCache.beginStore(key);
+    if (tile) {
+      const unsigned long start = micros();
+      JRESULT result = decodeAlbumImage(http.getStreamPtr(), chunked ? -1 : contentLength, chunked, tile);
+      // set before the tile can be found, so the draw that pushes it is the one timed
+      albumDecodeStartedMicros = result == JDR_OK ? max(start, 1ul) : 0;
+      albumArtCache.endStore(key, result == JDR_OK);
+      if (result == JDR_OK) {
+        log_i("decoded album image in %uus", micros() - start);
+        invalidateDisplay();
+      } else {
+        log_e("error %d decoding album image after %u of %d bytes", result, jpegStream.bytesRead(), contentLength);
+      }
+    }
   }
   http.end();
 }
 
+// the connection can't be closed until the decode is done with it, so this waits for the decode task
+JRESULT decodeAlbumImage(Client *stream, int length, bool chunked, uint16_t *tile) {
+  if (!jpgDecodeTask) return jpegStream.decode(stream, length, chunked, tile, albumSize, albumSize);
+  jpgStream = stream;
+  jpgStreamLength = length;
+  jpgStreamChunked = chunked;
+  jpgArtTile = tile;
+  jpgRequestingTask = xTaskGetCurrentTaskHandle();
+  xTaskNotifyGive(jpgDecodeTask);
+  ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  jpgStream = nullptr;
+  jpgArtTile = nullptr;
+  return jpgDecodeResult;
+}
+
+void jpgDecodeLoop(void *params) {
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    jpgDecodeResult =
+        jpegStream.decode(jpgStream, jpgStreamLength, jpgStreamChunked, jpgArtTile, albumSize, albumSize);
+    xTaskNotifyGive(jpgRequestingTask);
+  }
+}
+
 void updateFirmware() {
   if (checkedForUpdateMillis > 0 && millis() - checkedForUpdateMillis < 60000) {
     setStatusMessage("up to date");
@@ -3298,6 +3877,7 @@ void updateFirmware() {
     Serial.flush();
     delay(100);
     tft.fillScreen(TFT_BLACK);
+    tft.flushShadow();
     ESP.restart();
   }
 }
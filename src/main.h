@@ -10,10 +10,22 @@
 #include <list>
 #include <OneButton.h>
 #include <TFT_eSPI.h>
-#include <TJpg_Decoder.h>
 #include <WiFiClientSecure.h>
 
+#include "AlbumArtCache.h"
+#include "AnimationTimeline.h"
+#include "FrameScheduler.h"
+#include "GenreCatalog.h"
+#include "GlyphSprite.h"
+#include "IconAtlas.h"
+#include "JpegStream.h"
 #include "knobby.h"
+#include "Marquee.h"
+#include "RenderProfiler.h"
+#include "SpotifyId.h"
+#include "SpriteArena.h"
+#include "TextLineCache.h"
+#include "TftDisplay.h"
 
 extern const uint8_t GillSans24_vlw_start[] asm("_binary_GillSans24_vlw_start");
 extern const uint8_t icomoon24_vlw_start[] asm("_binary_icomoon24_vlw_start");
@@ -25,7 +37,6 @@ extern const char index_html_start[] asm("_binary_index_html_start");
 #define LINE_HEIGHT 27
 #define TFT_LIGHTBLACK 0x1082 /*  16,  16,  16 */
 #define TFT_DARKERGREY 0x4A49 /*  72,  72,  72 */
-#define SPOTIFY_ID_SIZE 22
 #define SPOTIFY_WAIT_MILLIS 1000
 
 enum MenuModes {
@@ -42,11 +53,6 @@ enum MenuModes {
   UserList = 6,
   DeviceList = 7
 };
-enum GenreSortModes {
-  AlphabeticSort = 0,
-  AlphabeticSuffixSort = 1
-};
-const int genreSortModesCount = 2;
 enum NowPlayingItems {
   LikeButton = 0,
   ShuffleButton = 1,
@@ -61,9 +67,10 @@ enum SettingsMenuModes {
   SettingsAbout = 0,
   SettingsUpdate = 1,
   SettingsOrientation = 2,
-  SettingsAddUser = 3,
-  SettingsRemoveUser = 4,
-  SettingsReset = 5
+  SettingsRandom = 3,
+  SettingsAddUser = 4,
+  SettingsRemoveUser = 5,
+  SettingsReset = 6
 };
 
 enum GrantTypes { gt_authorization_code, gt_refresh_token };
@@ -98,9 +105,28 @@ enum SpotifyRepeatModes {
 
 enum ExploreItemTypes { ExploreItemAlbum, ExploreItemArtist, ExploreItemPlaylist };
 
+enum PlaylistSources {
+  PlaylistSourceNone = -1,
+  PlaylistSourceGenre = 0,
+  PlaylistSourceCountry = 1,
+  PlaylistSourceUser = 2,
+  PlaylistSourceExplore = 3
+};
+
+typedef struct {
+  PlaylistSources source = PlaylistSourceNone;
+  int index = -1;
+} PlaylistEntity_t;
+
+typedef struct {
+  uint32_t hash = 0;
+  uint16_t index = 0;
+  PlaylistSources source = PlaylistSourceNone;
+} PlaylistIndexSlot_t;
+
 typedef struct {
   ExploreItemTypes type;
-  char id[SPOTIFY_ID_SIZE + 1] = "";
+  SpotifyId id;
   String name;
 } ExploreItem_t;
 
@@ -119,12 +145,12 @@ typedef struct {
 } SpotifyDevice_t;
 
 typedef struct {
-  char id[SPOTIFY_ID_SIZE + 1] = "";
+  SpotifyId id;
   String name;
 } SpotifyPlaylist_t;
 
 typedef struct {
-  char id[SPOTIFY_ID_SIZE + 1] = "";
+  SpotifyId id;
   char name[100] = "";
 } SpotifyArtist_t;
 
@@ -133,8 +159,8 @@ typedef struct {
   SpotifyArtist_t artists[3] = {};
   char artistsName[100] = "";
   char albumName[100] = "";
-  char albumId[SPOTIFY_ID_SIZE + 1] = "";
-  char trackId[SPOTIFY_ID_SIZE + 1] = "";
+  SpotifyId albumId;
+  SpotifyId trackId;
   char contextName[256] = "";
   char contextUri[100] = "";
   char imageUrl[100] = "";
@@ -162,11 +188,13 @@ bool contains(C&& c, T e) {
 
 const char *hostname = "knobby";
 const char *rootMenuItems[] = {"settings", "countries", "genres", "explore", "playlists", "now playing", "users", "devices"};
-const char *settingsMenuItems[] = {"about", "update", "orientation", "add user", "log out", "reset settings"};
+const char *settingsMenuItems[] = {"about", "update", "orientation", "random", "add user", "log out", "reset settings"};
 const uint8_t backlightChannel = 4;
 const int screenWidth = TFT_HEIGHT;
 const int screenHeight = TFT_WIDTH;
 const int centerX = screenWidth / 2;
+const unsigned int animationWaitMillis = 10;
+const unsigned int backlightFadeStepMillis = 40;
 const unsigned int clickEffectMillis = 80;
 const unsigned int debounceMillis = 10;
 const unsigned int doubleClickMaxMillis = 360;
@@ -176,6 +204,8 @@ const unsigned int inactivityFadeOutMillis = 4000;
 const unsigned int randomizingLengthMillis = 900;
 const unsigned int waitToShowProgressMillis = 2000;
 const unsigned int statusMessageMillis = 1750;
+// how long a catalog upload waits for the loop to let go of the partition, well under async_tcp's watchdog
+const unsigned int catalogSwapTimeoutMillis = 3000;
 const unsigned int newSessionSeconds = 60 * 60 * 10;
 const int textPadding = 9;
 const int textStartX = textPadding + 1;
@@ -187,7 +217,14 @@ const int lineTwo = lineOne + LINE_HEIGHT + 12;
 const int lineThree = lineTwo + LINE_HEIGHT;
 const int lineFour = lineThree + LINE_HEIGHT;
 const int lineSpacing = 3;
+const int batterySize = 31;
+const int iconSpriteSize = ICON_SIZE + 2;
+const int volumeControlHeight = 40;
+const int seekRadius = 4;
+const int renderStatsWidth = 160;
+const unsigned long renderStatsPrintMillis = 10000;
 const int albumSize = 64;
+static_assert(albumSize == ALBUM_ART_SIZE, "album art cache tiles are a different size");
 const int albumX = screenWidth - albumSize - 6;
 const int albumY = lineTwo;
 const uint16_t spotifyPollInterval = 10000;
@@ -254,25 +291,36 @@ RTC_DATA_ATTR SpotifyState_t spotifyState = {};
 RTC_DATA_ATTR bool spotifyStateLoaded = false;
 
 Knobby knobby;
-TFT_eSPI tft = TFT_eSPI(TFT_WIDTH, TFT_HEIGHT);
-TFT_eSprite img = TFT_eSprite(&tft);
-TFT_eSprite ico = TFT_eSprite(&tft);
-TFT_eSprite batterySprite = TFT_eSprite(&tft);
+TftDisplay tft = TftDisplay(TFT_WIDTH, TFT_HEIGHT);
+GlyphSprite img = GlyphSprite(&tft);
+GlyphSprite ico = GlyphSprite(&tft);
+GlyphSprite batterySprite = GlyphSprite(&tft);
+Marquee marquee = Marquee(&tft);
 ESP32Encoder knob;
 OneButton button;
 
 TaskHandle_t backgroundApiTask;
+// held by the background task while it runs an action, so the loop only swaps catalogs between them
+SemaphoreHandle_t backgroundApiLock;
 AsyncWebServer server(80);
 AsyncDNSServer dnsServer;
 ESPAsync_WiFiManager *wifiManager;
 WiFiClientSecure spotifyWifiClient;
 HTTPClient spotifyHttp;
 
-TaskHandle_t jpgDecodeTask;
-bool jpgDecodeReady = false;
-bool jpgRenderReady = false;
-uint16_t jpgBlockBuffer[16 * 16];
-int32_t jpgBlockX, jpgBlockY, jpgBlockW, jpgBlockH;
+TaskHandle_t jpgDecodeTask = nullptr;
+// notified when the decode it asked for is done
+TaskHandle_t jpgRequestingTask = nullptr;
+// the response to decode and the album art cache tile it goes into, set before the decode task is notified
+Client *jpgStream = nullptr;
+int jpgStreamLength = 0;
+bool jpgStreamChunked = false;
+uint16_t *jpgArtTile = nullptr;
+JRESULT jpgDecodeResult = JDR_OK;
+// when the image that's about to be drawn started decoding, or 0 once it's on the display
+volatile uint32_t albumDecodeStartedMicros = 0;
+// from starting to decode an album image until it's pushed to the display
+uint32_t albumDecodeMicros = 0;
 
 bool displayInvalidated = true;
 bool displayInvalidatedPartial = false;
@@ -286,12 +334,18 @@ bool knobRotatedWhileLongPressed = false;
 std::array<float, 12> knobVelocity;
 int knobVelocityPosition = 0;
 bool randomizingMenuAutoplay = false;
+bool randomByPopularity = false;
 time_t secondsAsleep = 0;
 bool showingNetworkInfo = false;
+bool showingRenderStats = false;
+unsigned long lastRenderStatsPrintMillis = 0;
 bool showingProgressBar = false;
 bool showingStatusMessage = false;
 char statusMessage[24] = "";
 char menuText[256] = "";
+MenuModes prefetchedMenuMode = NowPlaying;
+uint16_t prefetchedMenuIndex = 0;
+uint8_t prefetchedMenuNeighbors = 0;
 int pressedMenuIndex = -1;
 int rootMenuNowPlayingIndex = -1;
 int rootMenuExploreIndex = -1;
@@ -303,7 +357,6 @@ int explorePlaylistsGenreIndex = -1;
 std::vector<ExploreItem_t> explorePlaylists;
 long lastConnectedMillis = -1;
 unsigned long checkedForUpdateMillis = 0;
-unsigned long clickEffectEndMillis = 0;
 unsigned long inactivityMillis = 90000;
 unsigned long lastBatteryUpdateMillis = 0;
 unsigned long lastDelayMillis = 0;
@@ -313,27 +366,32 @@ unsigned long lastReconnectAttemptMillis = 0;
 unsigned long longPressStartedMillis = 0;
 unsigned long nowPlayingDisplayMillis = 0;
 unsigned long randomizingMenuEndMillis = 0;
-unsigned long randomizingMenuNextMillis = 0;
 unsigned long randomizingMenuTicks = 0;
-unsigned long statusMessageUntilMillis = 0;
 unsigned long menuClickedMillis = 0;
 unsigned long menuTimeoutMillis = 15000;
 unsigned long wifiConnectTimeoutMillis = 45000;
 bool wifiConnectWarning = false;
 size_t updateContentLength = 0;
+size_t catalogContentLength = 0;
+bool catalogUpdateFailed = false;
+// set by the /catalog handler, the loop switches to the built-in catalog before the partition is overwritten
+volatile bool catalogSwapRequested = false;
+// set by web handlers, which run on the async_tcp task, so only the loop draws to the display
+volatile bool displayRotationRequested = false;
+volatile bool restartRequested = false;
+volatile bool sleepRequested = false;
 
 long spotifyApiRequestStartedMillis = -1;
 String spotifyAuthCode;
 char spotifyCodeVerifier[44] = "";
 char spotifyCodeChallenge[44] = "";
-StreamString spotifyImage;
 bool spotifyImageDrawn = false;
 unsigned short emptyCurrentlyPlayingResponses = 0;
 uint32_t nextCurrentlyPlayingMillis = 0;
 bool spotifyGettingToken = false;
 SpotifyActions spotifyAction = Idle;
 SpotifyActions spotifyRetryAction = Idle;
-char spotifyGetPlaylistId[SPOTIFY_ID_SIZE + 1] = "";
+SpotifyId spotifyGetPlaylistId;
 char spotifyPlayUri[100] = "";
 int spotifyPlayAtMillis = -1;
 int spotifySeekToMillis = -1;
@@ -351,6 +409,9 @@ std::vector<SpotifyPlaylist_t> spotifyPlaylists;
 unsigned int spotifyPlaylistsCount = 0;
 bool spotifyPlaylistsLoaded = false;
 std::vector<SpotifyPlaylist_t> spotifyLinkedPlaylists;
+std::vector<PlaylistIndexSlot_t> playlistIndexSlots;
+// taken by anything reading playlistIndexSlots, and by updatePlaylistIndex to swap in a rebuilt table
+SemaphoreHandle_t playlistIndexLock;
 
 // Model-specific changes
 #ifdef LILYGO_WATCH_2019_WITH_TOUCH
@@ -381,17 +442,28 @@ void knobPressStarted();
 // Actions
 bool readDataJson();
 bool writeDataJson();
-bool onJpgBlockDecoded(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t *bitmap);
 void onOTAProgress(unsigned int progress, unsigned int total);
 uint16_t checkMenuSize(MenuModes mode);
 void drawBattery(unsigned int percent, unsigned int y, bool charging = false);
-void drawCenteredText(const char *text, uint16_t maxWidth, uint16_t maxLines = 1);
+void drawCenteredText(const char *text, uint16_t maxWidth, uint16_t maxLines = 1, uint32_t layout = 0);
+void finishTextLine(const TextLineKey_t &key, uint16_t lineNumber, bool draw);
+// render the lines of a text into the text line cache, pushing each one to the display as it's done if draw is set
+uint16_t renderCenteredText(const char *text, const TextLineKey_t &key, uint32_t layout, bool draw);
 void drawDivider(bool selected);
 void drawIcon(const String& icon, bool selected = false, bool clicked = false, bool disabled = false, bool filled = false);
+bool renderIcon(const String& icon, IconStates state);
+void fillIconAtlas();
 void drawMenuHeader(bool selected, const char *text = "", int totalSize = -1);
 void drawSetup();
+void drawNowPlayingText(const char *text, uint16_t maxWidth);
+void stopMarquee();
+void fadeBacklight(unsigned long now);
+void drawRenderStats();
 void invalidateDisplay(bool eraseDisplay = false);
+void clampCatalogIndexes();
+void swapToBuiltInCatalog();
 void playMenuPlaylist(MenuModes mode, uint16_t index);
+void prefetchMenuNeighbors();
 void playUri(const char *uri, const char *name);
 void setActiveDevice(SpotifyDevice_t *device);
 void setActiveUser(SpotifyUser_t *user);
@@ -400,6 +472,7 @@ void setMenuIndex(uint16_t newMenuIndex);
 void setMenuMode(MenuModes newMode, uint16_t newMenuIndex);
 void setStatusMessage(const char *message, unsigned long durationMs = statusMessageMillis);
 void setupKnob();
+void updatePlaylistIndex();
 void shutdownIfLowBattery();
 void startDeepSleep();
 void startRandomizingMenu(bool autoplay = false);
@@ -412,6 +485,10 @@ int formatMillis(char *output, unsigned long millis);
 void getContextName(char *name, const char *contextUri);
 uint16_t getMenuIndexForGenreIndex(uint16_t index);
 int getMenuIndexForPlaylist(const char *contextUri);
+SpotifyId getSpotifyIdFromUri(const char *uri, const char *prefix);
+PlaylistEntity_t findPlaylist(const SpotifyId &id);
+PlaylistEntity_t findIndexedPlaylist(const SpotifyId &id, PlaylistSources source);
+int findPlaylistIndex(const SpotifyId &id, PlaylistSources source);
 int getGenreIndexForMenuIndex(uint16_t index, MenuModes mode);
 void getMenuText(char *name, MenuModes mode, uint16_t index);
 void getContextUri(char *uri, MenuModes mode, uint16_t index);
@@ -419,6 +496,8 @@ bool isGenreMenu(MenuModes mode);
 bool isPlaylistMenu(MenuModes mode);
 unsigned long getLongPressedMillis();
 unsigned long getExtraLongPressedMillis();
+// a downloaded or cached image for the current album
+bool albumImageAvailable();
 bool shouldShowProgressBar();
 bool shouldShowRandom();
 bool shouldShowExploreMenu();
@@ -444,6 +523,7 @@ void spotifyTransferPlayback();
 void spotifyGetPlaylistInformation();
 void spotifyGetPlaylists();
 void spotifyGetImage();
+JRESULT decodeAlbumImage(Client *stream, int length, bool chunked, uint16_t *tile);
 
 bool spotifyNeedsNewAccessToken();
 void spotifyResetProgress(bool keepContext = false);
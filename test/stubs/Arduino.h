@@ -0,0 +1,63 @@
+#pragma once
+
+// Just enough of the Arduino core for the parts of the firmware the native tests build. Time only moves when a test
+// moves it, or when something waits.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <cmath>
+
+#define log_d(...) do {} while (0)
+#define log_i(...) do {} while (0)
+#define log_w(...) do {} while (0)
+// counted so tests can check what's reported as an error
+#define log_e(...) do { fakeErrorLogs()++; } while (0)
+
+#define constrain(amount, low, high) ((amount) < (low) ? (low) : ((amount) > (high) ? (high) : (amount)))
+#define pgm_read_byte(address) (*(const uint8_t *)(address))
+#define ps_malloc malloc
+
+using std::max;
+using std::min;
+
+inline unsigned long &fakeMicros() {
+  static unsigned long now = 0;
+  return now;
+}
+inline unsigned long micros() { return fakeMicros(); }
+
+inline unsigned &fakeErrorLogs() {
+  static unsigned count = 0;
+  return count;
+}
+inline unsigned long millis() { return fakeMicros() / 1000; }
+inline void delay(unsigned long ms) { fakeMicros() += ms * 1000; }
+
+inline long random(long howBig) { return howBig > 0 ? rand() % howBig : 0; }
+inline long random(long howSmall, long howBig) { return howSmall + random(howBig - howSmall); }
+
+class Print {
+ public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t byte) = 0;
+};
+
+class Stream : public Print {
+ public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+
+  size_t readBytes(uint8_t *buffer, size_t length) {
+    size_t count = 0;
+    while (count < length) {
+      const int byte = read();
+      if (byte < 0) break;
+      buffer[count++] = byte;
+    }
+    return count;
+  }
+};
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <Arduino.h>
+
+// the reading half of Arduino's Client
+class Client : public Stream {
+ public:
+  using Stream::read;
+  virtual int read(uint8_t *buffer, size_t size) = 0;
+  virtual uint8_t connected() = 0;
+};
@@ -0,0 +1,293 @@
+#pragma once
+
+// The parts of TFT_eSPI the sprites and display backends use, drawing into memory. Smooth fonts are read from .vlw
+// files the way TFT_eSPI reads them, and getUnicodeIndex, drawGlyph and alphaBlend follow the library, so sprites
+// built on top of this draw the same pixels the library would. Anything pushed straight to the TFT is only counted.
+
+#include <Arduino.h>
+
+#define TFT_BLACK 0x0000
+#define TFT_WHITE 0xffff
+#define TFT_DARKGREY 0x7bef
+#define TFT_LIGHTGREY 0xd69a
+#define TFT_RED 0xf800
+#define TFT_GREEN 0x07e0
+#define TFT_BLUE 0x001f
+
+typedef struct {
+  const uint8_t *gArray;
+  uint16_t gCount;
+  uint16_t yAdvance;
+  uint16_t spaceWidth;
+  int16_t ascent;
+  int16_t descent;
+  int16_t maxAscent;
+  int16_t maxDescent;
+} fontMetrics;
+
+class TFT_eSPI {
+ public:
+  TFT_eSPI(int16_t width = 240, int16_t height = 135) : _width(width), _height(height) {}
+  virtual ~TFT_eSPI() { unloadFont(); }
+
+  int16_t width() { return _width; }
+  int16_t height() { return _height; }
+
+  void loadFont(const uint8_t array[]) {
+    unloadFont();
+    gFont.gArray = array;
+    gFont.gCount = readInt32(array);
+    gFont.ascent = readInt32(array + 16);
+    gFont.descent = readInt32(array + 20);
+    gFont.maxAscent = gFont.ascent;
+    gFont.maxDescent = gFont.descent;
+    gFont.yAdvance = gFont.ascent + gFont.descent;
+    gFont.spaceWidth = gFont.yAdvance / 4;
+
+    gUnicode = new uint16_t[gFont.gCount];
+    gHeight = new uint16_t[gFont.gCount];
+    gWidth = new uint16_t[gFont.gCount];
+    gxAdvance = new uint16_t[gFont.gCount];
+    gdY = new int16_t[gFont.gCount];
+    gdX = new int8_t[gFont.gCount];
+    gBitmap = new uint32_t[gFont.gCount];
+    uint32_t bitmap = 24 + gFont.gCount * 28;
+    for (uint16_t i = 0; i < gFont.gCount; i++) {
+      const uint8_t *metrics = array + 24 + i * 28;
+      gUnicode[i] = readInt32(metrics);
+      gHeight[i] = readInt32(metrics + 4);
+      gWidth[i] = readInt32(metrics + 8);
+      gxAdvance[i] = readInt32(metrics + 12);
+      gdY[i] = readInt32(metrics + 16);
+      gdX[i] = readInt32(metrics + 20);
+      gBitmap[i] = bitmap;
+      bitmap += gWidth[i] * gHeight[i];
+      if (gUnicode[i] == 0x20) gFont.spaceWidth = gxAdvance[i];
+      // only printable ASCII counts toward the line height, like the library
+      if (gUnicode[i] > 0x20 && gUnicode[i] < 0xa0 && gUnicode[i] != 0x7f) {
+        if (gdY[i] > gFont.maxAscent && gUnicode[i] < 0x7f) gFont.maxAscent = gdY[i];
+        if (gHeight[i] - gdY[i] > gFont.maxDescent) gFont.maxDescent = gHeight[i] - gdY[i];
+      }
+    }
+    gFont.yAdvance = gFont.maxAscent + gFont.maxDescent;
+    fontLoaded = true;
+  }
+
+  void unloadFont() {
+    delete[] gUnicode;
+    delete[] gHeight;
+    delete[] gWidth;
+    delete[] gxAdvance;
+    delete[] gdY;
+    delete[] gdX;
+    delete[] gBitmap;
+    gUnicode = gHeight = gWidth = gxAdvance = nullptr;
+    gdY = nullptr;
+    gdX = nullptr;
+    gBitmap = nullptr;
+    fontLoaded = false;
+  }
+
+  bool getUnicodeIndex(uint16_t unicode, uint16_t *index) {
+    for (uint16_t i = 0; i < gFont.gCount; i++) {
+      if (gUnicode[i] == unicode) {
+        *index = i;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  uint16_t decodeUTF8(uint8_t *buffer, uint16_t *index, uint16_t remaining) {
+    uint16_t c = buffer[(*index)++];
+    if ((c & 0x80) == 0x00) return c;
+    if ((c & 0xe0) == 0xc0 && remaining > 1) return ((c & 0x1f) << 6) | (buffer[(*index)++] & 0x3f);
+    if ((c & 0xf0) == 0xe0 && remaining > 2) {
+      c = ((c & 0x0f) << 12) | ((buffer[(*index)++] & 0x3f) << 6);
+      return c | (buffer[(*index)++] & 0x3f);
+    }
+    return c;
+  }
+
+  void setTextColor(uint16_t fg, uint16_t bg) {
+    textcolor = fg;
+    textbgcolor = bg;
+  }
+  void setCursor(int16_t x, int16_t y) {
+    cursor_x = x;
+    cursor_y = y;
+  }
+  void printToSprite(char *text, uint16_t length) {
+    uint16_t n = 0;
+    while (n < length) drawGlyph(decodeUTF8((uint8_t *)text, &n, length - n));
+  }
+
+  virtual void drawGlyph(uint16_t code) {
+    uint16_t gNum = 0;
+    if (code < 0x21 || !getUnicodeIndex(code, &gNum)) {
+      if (code == 0x20) cursor_x += gFont.spaceWidth;
+      return;
+    }
+    uint16_t fg = textcolor;
+    uint16_t bg = textbgcolor;
+    const bool getBackground = fg == bg;
+
+    if (textwrapX && cursor_x + gWidth[gNum] + gdX[gNum] > width()) {
+      cursor_y += gFont.yAdvance;
+      cursor_x = 0;
+    }
+    if (textwrapY && cursor_y + gFont.yAdvance >= height()) cursor_y = 0;
+    if (cursor_x == 0) cursor_x -= gdX[gNum];
+
+    const uint8_t *bitmap = gFont.gArray + gBitmap[gNum];
+    const int16_t cy = cursor_y + gFont.maxAscent - gdY[gNum];
+    const int16_t cx = cursor_x + gdX[gNum];
+    int16_t xs = cx;
+    uint32_t dl = 0;
+    for (int y = 0; y < gHeight[gNum]; y++) {
+      for (int x = 0; x < gWidth[gNum]; x++) {
+        const uint8_t pixel = bitmap[x + gWidth[gNum] * y];
+        if (pixel == 0xff) {
+          if (dl == 0) xs = x + cx;
+          dl++;
+          continue;
+        }
+        if (dl) {
+          drawFastHLine(xs, y + cy, dl, fg);
+          dl = 0;
+        }
+        if (pixel) {
+          if (getBackground) bg = readPixel(x + cx, y + cy);
+          drawPixel(x + cx, y + cy, alphaBlend(pixel, fg, bg));
+        }
+      }
+      if (dl) {
+        drawFastHLine(xs, y + cy, dl, fg);
+        dl = 0;
+      }
+    }
+    cursor_x += gxAdvance[gNum];
+  }
+
+  uint16_t alphaBlend(uint8_t alpha, uint16_t fgc, uint16_t bgc) {
+    uint32_t rxb = bgc & 0xf81f;
+    rxb += ((fgc & 0xf81f) - rxb) * (alpha >> 2) >> 6;
+    uint32_t xgx = bgc & 0x07e0;
+    xgx += ((fgc & 0x07e0) - xgx) * alpha >> 8;
+    return (rxb & 0xf81f) | (xgx & 0x07e0);
+  }
+
+  virtual void drawPixel(int32_t x, int32_t y, uint32_t color) { directDraws++; }
+  virtual void drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color) {
+    for (int32_t i = 0; i < w; i++) drawPixel(x + i, y, color);
+  }
+  virtual void drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color) {
+    for (int32_t i = 0; i < h; i++) drawPixel(x, y + i, color);
+  }
+  virtual void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) {
+    for (int32_t i = 0; i < h; i++) drawFastHLine(x, y + i, w, color);
+  }
+  virtual uint16_t readPixel(int32_t x, int32_t y) { return 0; }
+
+  void startWrite() {}
+  void endWrite() {}
+  bool getSwapBytes() { return _swapBytes; }
+  void setSwapBytes(bool swap) { _swapBytes = swap; }
+  void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t *data) { directDraws++; }
+
+  fontMetrics gFont = {};
+  uint16_t *gUnicode = nullptr;
+  uint16_t *gHeight = nullptr;
+  uint16_t *gWidth = nullptr;
+  uint16_t *gxAdvance = nullptr;
+  int16_t *gdY = nullptr;
+  int8_t *gdX = nullptr;
+  uint32_t *gBitmap = nullptr;
+  bool fontLoaded = false;
+
+  uint32_t textcolor = TFT_WHITE;
+  uint32_t textbgcolor = TFT_BLACK;
+  int32_t cursor_x = 0;
+  int32_t cursor_y = 0;
+  bool textwrapX = false;
+  bool textwrapY = false;
+
+  // everything that reached the TFT without going through a DisplayBackend
+  uint32_t directDraws = 0;
+
+ protected:
+  static uint32_t readInt32(const uint8_t *p) { return (uint32_t)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3]; }
+
+  int16_t _width;
+  int16_t _height;
+  bool _swapBytes = false;
+};
+
+// 16 bit sprites hold byte swapped RGB565, 4 bit ones hold palette indexes two to a byte, the first in the high bits
+class TFT_eSprite : public TFT_eSPI {
+ public:
+  explicit TFT_eSprite(TFT_eSPI *tft) : TFT_eSPI(0, 0), _tft(tft) {}
+  ~TFT_eSprite() { deleteSprite(); }
+
+  void *setColorDepth(int8_t depth) {
+    _depth = depth;
+    return nullptr;
+  }
+  int8_t getColorDepth() { return _depth; }
+
+  void *createSprite(int16_t w, int16_t h, uint8_t frames = 1) {
+    deleteSprite();
+    _buffer = (uint8_t *)calloc(_depth == 4 ? (w * h + 1) / 2 : w * h * 2, 1);
+    if (!_buffer) return nullptr;
+    _width = w;
+    _height = h;
+    spritesCreated++;
+    return _buffer;
+  }
+  void deleteSprite() {
+    free(_buffer);
+    _buffer = nullptr;
+    _width = _height = 0;
+  }
+  void *getPointer() { return _buffer; }
+  bool created() { return _buffer != nullptr; }
+
+  void createPalette(uint16_t *palette, uint8_t colors = 16) {
+    memcpy(_palette, palette, min((int)colors, 16) * sizeof(uint16_t));
+  }
+  uint16_t getPaletteColor(uint8_t index) { return _palette[index & 0x0f]; }
+
+  void drawPixel(int32_t x, int32_t y, uint32_t color) override {
+    if (!_buffer || x < 0 || y < 0 || x >= _width || y >= _height) return;
+    if (_depth == 4) {
+      uint8_t &pair = _buffer[(y * _width + x) >> 1];
+      pair = x & 1 ? (pair & 0xf0) | (color & 0x0f) : (pair & 0x0f) | ((color & 0x0f) << 4);
+    } else {
+      ((uint16_t *)_buffer)[y * _width + x] = (uint16_t)((color >> 8) | (color << 8));
+    }
+  }
+  uint16_t readPixel(int32_t x, int32_t y) override {
+    if (!_buffer || x < 0 || y < 0 || x >= _width || y >= _height) return 0;
+    if (_depth == 4) {
+      const uint8_t pair = _buffer[(y * _width + x) >> 1];
+      return x & 1 ? pair & 0x0f : pair >> 4;
+    }
+    const uint16_t color = ((uint16_t *)_buffer)[y * _width + x];
+    return (color >> 8) | (color << 8);
+  }
+  void fillSprite(uint32_t color) { fillRect(0, 0, _width, _height, color); }
+
+  void pushSprite(int32_t x, int32_t y) { _tft->directDraws++; }
+  bool pushSprite(int32_t x, int32_t y, int32_t sx, int32_t sy, int32_t sw, int32_t sh) {
+    _tft->directDraws++;
+    return true;
+  }
+
+  uint32_t spritesCreated = 0;
+
+ protected:
+  TFT_eSPI *_tft;
+  uint8_t *_buffer = nullptr;
+  int8_t _depth = 16;
+  uint16_t _palette[16] = {};
+};
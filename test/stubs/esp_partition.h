@@ -0,0 +1,53 @@
+#pragma once
+
+// a catalog partition held in memory, tests point fakeCatalogPartition() at the bytes they want it to hold
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef int esp_err_t;
+typedef uint32_t spi_flash_mmap_handle_t;
+typedef int esp_partition_subtype_t;
+
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_PARTITION_TYPE_DATA 1
+#define SPI_FLASH_MMAP_DATA 0
+#define SPI_FLASH_SEC_SIZE 4096
+
+typedef struct {
+  uint32_t size;
+  uint8_t *data;
+} esp_partition_t;
+
+inline esp_partition_t &fakeCatalogPartition() {
+  static esp_partition_t partition = {0, nullptr};
+  return partition;
+}
+
+inline const esp_partition_t *esp_partition_find_first(int type, esp_partition_subtype_t subtype, const char *label) {
+  return fakeCatalogPartition().data ? &fakeCatalogPartition() : nullptr;
+}
+
+inline esp_err_t esp_partition_mmap(const esp_partition_t *partition, size_t offset, size_t size, int memory,
+                                    const void **out, spi_flash_mmap_handle_t *handle) {
+  if (offset + size > partition->size) return ESP_FAIL;
+  *out = partition->data + offset;
+  *handle = 1;
+  return ESP_OK;
+}
+
+inline void spi_flash_munmap(spi_flash_mmap_handle_t handle) {}
+
+inline esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size) {
+  if (offset + size > partition->size) return ESP_FAIL;
+  memset(partition->data + offset, 0xff, size);
+  return ESP_OK;
+}
+
+inline esp_err_t esp_partition_write(const esp_partition_t *partition, size_t offset, const void *data, size_t size) {
+  if (offset + size > partition->size) return ESP_FAIL;
+  memcpy(partition->data + offset, data, size);
+  return ESP_OK;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <stdint.h>
+
+// the ROM's little endian crc32, the same one zlib and load_genres.rb use
+inline uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *data, uint32_t length) {
+  crc = ~crc;
+  while (length--) {
+    crc ^= *data++;
+    for (int bit = 0; bit < 8; bit++) crc = crc & 1 ? (crc >> 1) ^ 0xedb88320 : crc >> 1;
+  }
+  return ~crc;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+// the tests run on one thread, so locks only have to keep count
+
+#include <stdint.h>
+
+typedef int BaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS pdTRUE
+#define portMAX_DELAY 0xffffffff
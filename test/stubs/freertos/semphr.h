@@ -0,0 +1,16 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+typedef int *SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex() { return new int(1); }
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t lock, TickType_t wait) {
+  if (*lock == 0) return pdFALSE;
+  (*lock)--;
+  return pdTRUE;
+}
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t lock) {
+  (*lock)++;
+  return pdTRUE;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+// fonts are embedded into the firmware, the tests read them from src
+
+#include <stdio.h>
+
+#include <string>
+
+inline std::string readSourceFile(const char *name) {
+  std::string path = __FILE__;
+  path = path.substr(0, path.rfind("test/stubs/")) + "src/" + name;
+  FILE *file = fopen(path.c_str(), "rb");
+  if (!file) return "";
+  std::string data;
+  char buffer[4096];
+  size_t read;
+  while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) data.append(buffer, read);
+  fclose(file);
+  return data;
+}
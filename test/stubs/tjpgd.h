@@ -0,0 +1,39 @@
+#pragma once
+
+// The interface of tjpgd R0.03 as TJpg_Decoder bundles it, configured for RGB565. There's no decoder behind it, tests
+// that use it define jd_prepare and jd_decomp themselves.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define JD_FORMAT 1
+#define JD_FASTDECODE 1
+
+typedef enum {
+  JDR_OK = 0,
+  JDR_INTR,
+  JDR_INP,
+  JDR_MEM1,
+  JDR_MEM2,
+  JDR_PAR,
+  JDR_FMT1,
+  JDR_FMT2,
+  JDR_FMT3
+} JRESULT;
+
+typedef struct {
+  uint16_t left, right, top, bottom;
+} JRECT;
+
+typedef struct JDEC JDEC;
+struct JDEC {
+  uint16_t width, height;
+  void *pool;
+  size_t sz_pool;
+  size_t (*infunc)(JDEC *, uint8_t *, size_t);
+  void *device;
+  uint8_t swap;
+};
+
+JRESULT jd_prepare(JDEC *jd, size_t (*infunc)(JDEC *, uint8_t *, size_t), void *pool, size_t sz_pool, void *dev);
+JRESULT jd_decomp(JDEC *jd, int (*outfunc)(JDEC *, void *, JRECT *), uint8_t scale);
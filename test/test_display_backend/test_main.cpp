@@ -0,0 +1,125 @@
+#include <unity.h>
+
+#include <string>
+#include <vector>
+
+#include "GlyphSprite.cpp"
+#include "SpriteArena.cpp"
+#include "source_files.h"
+
+static const int32_t screenWidth = 240;
+static const int32_t screenHeight = 135;
+static TFT_eSPI tft(screenWidth, screenHeight);
+static std::string font;
+static uint16_t screen[screenWidth * screenHeight];
+
+// what a sprite pixel should look like on the display, byte swapped like everything pushed through a DisplayBackend
+static uint16_t displayed(GlyphSprite &sprite, int32_t x, int32_t y) {
+  const uint16_t color = sprite.paletted() ? sprite.getPaletteColor(sprite.readPixel(x, y)) : sprite.readPixel(x, y);
+  return (color >> 8) | (color << 8);
+}
+
+// the sprite's w by h corner should be on screen at x, y, clipped to the screen, with nothing around it touched
+static void assertPushed(GlyphSprite &sprite, int32_t x, int32_t y, int32_t w, int32_t h, uint16_t background) {
+  for (int32_t row = 0; row < screenHeight; row++) {
+    for (int32_t column = 0; column < screenWidth; column++) {
+      const bool inside = column >= x && column < x + w && row >= y && row < y + h;
+      const uint16_t expected = inside ? displayed(sprite, column - x, row - y) : background;
+      TEST_ASSERT_EQUAL_HEX16(expected, screen[row * screenWidth + column]);
+    }
+  }
+}
+
+void setUp() {
+  for (auto &pixel : screen) pixel = 0x1234;
+  tft.directDraws = 0;
+}
+void tearDown() {}
+
+void test_borrowed_sprites_reach_the_display() {
+  FramebufferDisplay display(screen, screenWidth, screenHeight);
+  SpriteArena arena;
+  GlyphSprite img(&tft);
+  img.loadFont((const uint8_t *)font.data());
+  arena.setDisplay(&display);
+  TEST_ASSERT_TRUE(arena.reserve(img, 200, 32));
+
+  // smaller than reserved, so the rows pushed are strided
+  TEST_ASSERT_TRUE(arena.borrow(img, 150, 28));
+  img.setTextColor(TFT_WHITE, TFT_BLACK);
+  img.setCursor(2, 2);
+  img.printToSprite((char *)"Deep Vocal House", 16);
+  TEST_ASSERT_TRUE(img.cursor_x > 100);
+  arena.push(img, 40, 50);
+  arena.giveBack(img);
+  assertPushed(img, 40, 50, 150, 28, 0x1234);
+  TEST_ASSERT_EQUAL_UINT32(1, display.regions());
+  TEST_ASSERT_EQUAL_UINT32(0, tft.directDraws);
+}
+
+void test_sprites_are_clipped_to_the_display() {
+  FramebufferDisplay display(screen, screenWidth, screenHeight);
+  SpriteArena arena;
+  GlyphSprite img(&tft);
+  img.loadFont((const uint8_t *)font.data());
+  arena.setDisplay(&display);
+  TEST_ASSERT_TRUE(arena.reserve(img, 200, 32));
+
+  TEST_ASSERT_TRUE(arena.borrow(img, 200, 32));
+  img.setTextColor(0x3a4f, TFT_DARKGREY);
+  arena.clear(img, TFT_DARKGREY);
+  img.setCursor(0, 2);
+  img.printToSprite((char *)"Électro Swing", 14);
+  arena.push(img, 100, 120);
+  arena.giveBack(img);
+  assertPushed(img, 100, 120, 200, 32, 0x1234);
+  TEST_ASSERT_EQUAL_UINT32(0, tft.directDraws);
+}
+
+// 4 bit sprites are expanded in chunks of GLYPH_PALETTE_EXPAND_PIXELS, so a tall one takes a few regions
+void test_paletted_sprites_are_expanded() {
+  FramebufferDisplay display(screen, screenWidth, screenHeight);
+  SpriteArena arena;
+  GlyphSprite battery(&tft);
+  battery.loadFont((const uint8_t *)font.data());
+  battery.setColorDepth(4);
+  arena.setDisplay(&display);
+  TEST_ASSERT_TRUE(arena.reserve(battery, 63, 40));
+
+  TEST_ASSERT_TRUE(arena.borrow(battery, 61, 40));
+  battery.setTextColor(TFT_GREEN, TFT_BLACK);
+  battery.setCursor(1, 4);
+  battery.printToSprite((char *)"87%", 3);
+  TEST_ASSERT_TRUE(battery.cursor_x > 20);
+  arena.push(battery, 170, 10);
+  arena.giveBack(battery);
+  assertPushed(battery, 170, 10, 61, 40, 0x1234);
+  TEST_ASSERT_TRUE(display.regions() > 1);
+  TEST_ASSERT_EQUAL_UINT32(0, tft.directDraws);
+}
+
+// without a display there's nowhere to push, and nothing goes around it to the TFT
+void test_nothing_is_pushed_without_a_display() {
+  SpriteArena arena;
+  GlyphSprite img(&tft);
+  TEST_ASSERT_TRUE(arena.reserve(img, 20, 20));
+  TEST_ASSERT_TRUE(arena.borrow(img, 20, 20));
+  arena.push(img, 0, 0);
+  arena.giveBack(img);
+  TEST_ASSERT_EQUAL_UINT32(0, tft.directDraws);
+}
+
+int main() {
+  font = readSourceFile("GillSans24.vlw");
+  if (font.empty()) {
+    printf("fonts not found in src\n");
+    return 1;
+  }
+
+  UNITY_BEGIN();
+  RUN_TEST(test_borrowed_sprites_reach_the_display);
+  RUN_TEST(test_sprites_are_clipped_to_the_display);
+  RUN_TEST(test_paletted_sprites_are_expanded);
+  RUN_TEST(test_nothing_is_pushed_without_a_display);
+  return UNITY_END();
+}
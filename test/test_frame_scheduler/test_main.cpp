@@ -0,0 +1,47 @@
+#include <unity.h>
+
+#include "FrameScheduler.cpp"
+
+void setUp() { fakeMicros() = 0; }
+void tearDown() {}
+
+// settings past 255 used to wrap around before they were clamped, so 256 came out as 1 fps
+void test_max_fps_is_clamped_before_narrowing() {
+  FrameScheduler scheduler;
+  const int settings[][2] = {{24, 24}, {60, 60}, {61, 60}, {256, 60}, {300, 60}, {70000, 60}, {0, 1}, {-5, 1}};
+  for (auto &setting : settings) {
+    scheduler.setMaxFps(setting[0]);
+    TEST_ASSERT_EQUAL_UINT8(setting[1], scheduler.maxFps());
+    TEST_ASSERT_EQUAL_UINT32(1000 / setting[1], scheduler.frameIntervalMillis());
+  }
+}
+
+void test_frames_wait_for_the_interval() {
+  FrameScheduler scheduler;
+  scheduler.setMaxFps(20);
+  delay(1000);
+  TEST_ASSERT_TRUE(scheduler.frameDue(millis()));
+  scheduler.beginFrame();
+  delay(10);
+  scheduler.endFrame();
+  TEST_ASSERT_FALSE(scheduler.frameDue(millis()));
+  delay(40);
+  TEST_ASSERT_TRUE(scheduler.frameDue(millis()));
+  TEST_ASSERT_EQUAL_UINT32(10000, scheduler.lastFrameMicros());
+}
+
+void test_widgets_are_due_once() {
+  FrameScheduler scheduler;
+  scheduler.scheduleWidget(StatusMessageWidget, 100);
+  TEST_ASSERT_FALSE(scheduler.widgetDue(StatusMessageWidget, 99));
+  TEST_ASSERT_TRUE(scheduler.widgetDue(StatusMessageWidget, 100));
+  TEST_ASSERT_FALSE(scheduler.widgetDue(StatusMessageWidget, 200));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_max_fps_is_clamped_before_narrowing);
+  RUN_TEST(test_frames_wait_for_the_interval);
+  RUN_TEST(test_widgets_are_due_once);
+  return UNITY_END();
+}
@@ -0,0 +1,237 @@
+#include <unity.h>
+
+#include <vector>
+
+#include "GenreCatalog.cpp"
+
+// the built-in tables, which a catalog written to the partition should read back the same as
+static GenreCatalog builtIn;
+// set up again by each test, after writing a catalog to the partition
+static GenreCatalog catalog;
+static std::vector<uint8_t> partition;
+
+// the same layout write_genres_catalog in load_genres.rb writes, built from the tables in genres.h
+static std::vector<uint8_t> buildCatalog(uint32_t version) {
+  std::vector<uint8_t> data(sizeof(GenreCatalogHeader_t));
+  auto addSection = [&data](const void *section, size_t size) {
+    data.resize((data.size() + 7) & ~7);
+    const uint32_t offset = data.size();
+    data.insert(data.end(), (const uint8_t *)section, (const uint8_t *)section + size);
+    return offset;
+  };
+
+  GenreCatalogHeader_t header = {};
+  header.magic = GENRE_CATALOG_MAGIC;
+  header.format = GENRE_CATALOG_FORMAT;
+  header.headerSize = sizeof(GenreCatalogHeader_t);
+  header.version = version;
+  header.genreCount = GENRE_COUNT;
+  header.countryCount = COUNTRY_COUNT;
+  header.playlistHashBuckets = PLAYLIST_HASH_BUCKETS;
+  header.playlistHashSize = PLAYLIST_HASH_SIZE;
+  header.genreNameBlockSize = GENRE_NAME_BLOCK_SIZE;
+  header.genreNames = addSection(genreNames, sizeof(genreNames));
+  header.genreNameBlockOffsets = addSection(genreNameBlockOffsets, sizeof(genreNameBlockOffsets));
+  header.genrePlaylists = addSection(genrePlaylists, sizeof(genrePlaylists));
+  header.genreColors = addSection(genreColors, sizeof(genreColors));
+  header.countryNames = addSection(countryNames, sizeof(countryNames));
+  header.countryNameOffsets = addSection(countryNameOffsets, sizeof(countryNameOffsets));
+  header.countryPlaylists = addSection(countryPlaylists, sizeof(countryPlaylists));
+  header.playlistHashDisplacements = addSection(playlistHashDisplacements, sizeof(playlistHashDisplacements));
+  header.playlistHashEntities = addSection(playlistHashEntities, sizeof(playlistHashEntities));
+  header.genrePrefixStarts = addSection(genrePrefixStarts, sizeof(genrePrefixStarts));
+  header.countryPrefixKeys = addSection(countryPrefixKeys, sizeof(countryPrefixKeys));
+  header.countryPrefixStarts = addSection(countryPrefixStarts, sizeof(countryPrefixStarts));
+  header.textLayouts = addSection(nullptr, 0);
+
+  GenreCatalogOrder_t order = {};
+  order.sortMode = AlphabeticSuffixSort;
+  order.genreIndexes = addSection(genreIndexes_suffix, sizeof(genreIndexes_suffix));
+  order.genreMenuIndexes = addSection(genreMenuIndexes_suffix, sizeof(genreMenuIndexes_suffix));
+  header.orderCount = 1;
+  header.orders = addSection(&order, sizeof(order));
+
+  header.size = data.size();
+  header.crc = esp_rom_crc32_le(0, data.data() + sizeof(header), data.size() - sizeof(header));
+  memcpy(data.data(), &header, sizeof(header));
+  return data;
+}
+
+static GenreCatalogHeader_t *headerOf(std::vector<uint8_t> &data) { return (GenreCatalogHeader_t *)data.data(); }
+
+template <typename T>
+static T *sectionOf(std::vector<uint8_t> &data, uint32_t offset) {
+  return (T *)(data.data() + offset);
+}
+
+// after a change that should only fail the bounds checks, not the checksum
+static void updateCrc(std::vector<uint8_t> &data) {
+  auto header = headerOf(data);
+  header->crc = esp_rom_crc32_le(0, data.data() + header->headerSize, header->size - header->headerSize);
+}
+
+// write a catalog the way the /catalog upload does, in pieces, and report whether it was accepted
+static bool writeCatalog(const std::vector<uint8_t> &data) {
+  if (!catalog.beginUpdate(data.size())) return false;
+  for (size_t offset = 0; offset < data.size(); offset += 1000) {
+    if (!catalog.writeUpdate(data.data() + offset, min((size_t)1000, data.size() - offset))) return false;
+  }
+  return catalog.endUpdate();
+}
+
+// a fresh catalog with the partition erased, back on the built-in tables
+static void eraseCatalog() {
+  std::fill(partition.begin(), partition.end(), 0xff);
+  catalog.setup();
+}
+
+void setUp() {
+  partition.assign(0x80000, 0xff);
+  fakeCatalogPartition().data = partition.data();
+  fakeCatalogPartition().size = partition.size();
+}
+
+void tearDown() {}
+
+void test_written_catalog_reads_back_like_the_built_in_tables() {
+  eraseCatalog();
+  TEST_ASSERT_TRUE(catalog.isBuiltIn());
+  TEST_ASSERT_TRUE(writeCatalog(buildCatalog(GENRE_CATALOG_VERSION + 1)));
+
+  catalog.setup();
+  TEST_ASSERT_FALSE(catalog.isBuiltIn());
+  TEST_ASSERT_EQUAL_UINT32(GENRE_CATALOG_VERSION + 1, catalog.version());
+  TEST_ASSERT_EQUAL_UINT16(builtIn.genreCount(), catalog.genreCount());
+  TEST_ASSERT_EQUAL_UINT16(builtIn.countryCount(), catalog.countryCount());
+
+  char expected[GENRE_NAME_SIZE];
+  char name[GENRE_NAME_SIZE];
+  for (uint16_t i = 0; i < catalog.genreCount(); i++) {
+    TEST_ASSERT_EQUAL_STRING(builtIn.genreName(i, expected, sizeof(expected)),
+                             catalog.genreName(i, name, sizeof(name)));
+    TEST_ASSERT_TRUE(builtIn.genrePlaylist(i) == catalog.genrePlaylist(i));
+    TEST_ASSERT_EQUAL_UINT16(builtIn.genreColor(i), catalog.genreColor(i));
+    TEST_ASSERT_EQUAL_INT(i, catalog.findPlaylist(catalog.genrePlaylist(i)));
+  }
+  for (uint16_t i = 0; i < catalog.countryCount(); i++) {
+    TEST_ASSERT_EQUAL_STRING(builtIn.countryName(i), catalog.countryName(i));
+    TEST_ASSERT_TRUE(builtIn.countryPlaylist(i) == catalog.countryPlaylist(i));
+    TEST_ASSERT_EQUAL_INT(catalog.genreCount() + i, catalog.findPlaylist(catalog.countryPlaylist(i)));
+  }
+
+  TEST_ASSERT_NOT_NULL(catalog.genreIndexes(AlphabeticSuffixSort));
+  TEST_ASSERT_EQUAL_UINT16_ARRAY(builtIn.genreIndexes(AlphabeticSuffixSort),
+                                 catalog.genreIndexes(AlphabeticSuffixSort), catalog.genreCount());
+  TEST_ASSERT_EQUAL_UINT16_ARRAY(builtIn.genreMenuIndexes(AlphabeticSuffixSort),
+                                 catalog.genreMenuIndexes(AlphabeticSuffixSort), catalog.genreCount());
+  TEST_ASSERT_NULL(catalog.genreIndexes(AlphabeticSort));
+}
+
+void test_written_catalog_jumps_between_prefixes_like_the_built_in_tables() {
+  eraseCatalog();
+  TEST_ASSERT_TRUE(writeCatalog(buildCatalog(GENRE_CATALOG_VERSION)));
+  catalog.setup();
+  TEST_ASSERT_FALSE(catalog.isBuiltIn());
+
+  for (int direction = -1; direction <= 1; direction += 2) {
+    for (int firstLetter = 0; firstLetter <= 1; firstLetter++) {
+      for (uint16_t i = 0; i < catalog.genreCount(); i++) {
+        const uint16_t jump = catalog.genrePrefixJump(i, direction, firstLetter);
+        TEST_ASSERT_EQUAL_UINT16(builtIn.genrePrefixJump(i, direction, firstLetter), jump);
+        TEST_ASSERT_TRUE(jump < catalog.genreCount());
+      }
+      for (uint16_t i = 0; i < catalog.countryCount(); i++) {
+        const uint16_t jump = catalog.countryPrefixJump(i, direction, firstLetter);
+        TEST_ASSERT_EQUAL_UINT16(builtIn.countryPrefixJump(i, direction, firstLetter), jump);
+        TEST_ASSERT_TRUE(jump < catalog.countryCount());
+      }
+    }
+  }
+}
+
+void test_older_catalog_is_not_used() {
+  eraseCatalog();
+  TEST_ASSERT_TRUE(writeCatalog(buildCatalog(GENRE_CATALOG_VERSION - 1)));
+  catalog.setup();
+  TEST_ASSERT_TRUE(catalog.isBuiltIn());
+  TEST_ASSERT_EQUAL_UINT32(GENRE_CATALOG_VERSION, catalog.version());
+}
+
+void test_flipped_checksum_is_rejected() {
+  auto data = buildCatalog(GENRE_CATALOG_VERSION + 1);
+  headerOf(data)->crc ^= 1;
+  eraseCatalog();
+  TEST_ASSERT_FALSE(writeCatalog(data));
+  catalog.setup();
+  TEST_ASSERT_TRUE(catalog.isBuiltIn());
+
+  // or any flipped bit in the body
+  data = buildCatalog(GENRE_CATALOG_VERSION + 1);
+  data[data.size() / 2] ^= 0x10;
+  eraseCatalog();
+  TEST_ASSERT_FALSE(writeCatalog(data));
+  catalog.setup();
+  TEST_ASSERT_TRUE(catalog.isBuiltIn());
+}
+
+void test_out_of_range_indexes_are_rejected() {
+  auto assertRejected = [](std::vector<uint8_t> &data) {
+    updateCrc(data);
+    eraseCatalog();
+    TEST_ASSERT_FALSE(writeCatalog(data));
+    catalog.setup();
+    TEST_ASSERT_TRUE(catalog.isBuiltIn());
+  };
+
+  // a key past the end of the prefix starts
+  auto data = buildCatalog(GENRE_CATALOG_VERSION + 1);
+  sectionOf<uint16_t>(data, headerOf(data)->countryPrefixKeys)[0] = GENRE_PREFIX_CLASSES * GENRE_PREFIX_CLASSES;
+  assertRejected(data);
+
+  // a key naming a group the country isn't in
+  data = buildCatalog(GENRE_CATALOG_VERSION + 1);
+  sectionOf<uint16_t>(data, headerOf(data)->countryPrefixKeys)[0] = 0;
+  assertRejected(data);
+
+  // a prefix start past the last genre, or out of order
+  data = buildCatalog(GENRE_CATALOG_VERSION + 1);
+  sectionOf<uint16_t>(data, headerOf(data)->genrePrefixStarts)[GENRE_PREFIX_CLASSES * GENRE_PREFIX_CLASSES] += 1;
+  assertRejected(data);
+  data = buildCatalog(GENRE_CATALOG_VERSION + 1);
+  sectionOf<uint16_t>(data, headerOf(data)->countryPrefixStarts)[GENRE_PREFIX_CLASSES * GENRE_PREFIX_CLASSES - 1] =
+      COUNTRY_COUNT + 1;
+  assertRejected(data);
+
+  // a sorted genre index past the last genre, or menu indexes that aren't its inverse
+  data = buildCatalog(GENRE_CATALOG_VERSION + 1);
+  auto order = sectionOf<GenreCatalogOrder_t>(data, headerOf(data)->orders);
+  sectionOf<uint16_t>(data, order->genreIndexes)[0] = GENRE_COUNT;
+  assertRejected(data);
+  data = buildCatalog(GENRE_CATALOG_VERSION + 1);
+  order = sectionOf<GenreCatalogOrder_t>(data, headerOf(data)->orders);
+  auto menuIndexes = sectionOf<uint16_t>(data, order->genreMenuIndexes);
+  std::swap(menuIndexes[0], menuIndexes[1]);
+  assertRejected(data);
+
+  // a country name starting anywhere but right after the one before it
+  data = buildCatalog(GENRE_CATALOG_VERSION + 1);
+  sectionOf<uint16_t>(data, headerOf(data)->countryNameOffsets)[COUNTRY_COUNT - 1] = 0xffff;
+  assertRejected(data);
+  data = buildCatalog(GENRE_CATALOG_VERSION + 1);
+  sectionOf<uint16_t>(data, headerOf(data)->countryNameOffsets)[1] += 1;
+  assertRejected(data);
+
+}
+
+int main() {
+  fakeCatalogPartition() = {0, nullptr};
+  builtIn.setup();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_written_catalog_reads_back_like_the_built_in_tables);
+  RUN_TEST(test_written_catalog_jumps_between_prefixes_like_the_built_in_tables);
+  RUN_TEST(test_older_catalog_is_not_used);
+  RUN_TEST(test_flipped_checksum_is_rejected);
+  RUN_TEST(test_out_of_range_indexes_are_rejected);
+  return UNITY_END();
+}
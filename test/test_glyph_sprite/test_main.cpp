@@ -0,0 +1,204 @@
+#include <unity.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "GenreCatalog.cpp"
+#include "GlyphSprite.cpp"
+#include "source_files.h"
+
+static TFT_eSPI tft;
+static std::vector<std::string> fonts;
+// every built-in genre name, the text drawn and measured most often
+static std::vector<std::string> names;
+
+// the blend ramps, which are protected in GlyphSprite
+class RampSprite : public GlyphSprite {
+ public:
+  explicit RampSprite(TFT_eSPI *tft) : GlyphSprite(tft) {}
+  using GlyphSprite::blendRamp;
+};
+
+static double elapsedMillis(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// the width drawCenteredText measures a name at, with a lookup for each character
+template <typename Lookup>
+static uint32_t measure(GlyphSprite &sprite, const std::string &text, Lookup lookup) {
+  uint32_t width = 0;
+  uint16_t n = 0;
+  while (n < text.size()) {
+    const uint16_t unicode = sprite.decodeUTF8((uint8_t *)text.data(), &n, text.size() - n);
+    uint16_t index;
+    width += lookup(unicode, &index) ? sprite.gxAdvance[index] : sprite.gFont.spaceWidth;
+  }
+  return width;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_glyph_index_matches_get_unicode_index() {
+  for (auto &font : fonts) {
+    GlyphSprite sprite(&tft);
+    sprite.loadFont((const uint8_t *)font.data());
+    for (uint32_t unicode = 0; unicode <= 0xffff; unicode++) {
+      uint16_t expected = GLYPH_NOT_FOUND;
+      uint16_t found = GLYPH_NOT_FOUND;
+      const bool expectedFound = sprite.getUnicodeIndex(unicode, &expected);
+      TEST_ASSERT_EQUAL(expectedFound, sprite.glyphIndex(unicode, &found));
+      if (expectedFound) TEST_ASSERT_EQUAL_UINT16(expected, found);
+    }
+  }
+}
+
+void test_unloading_clears_the_tables() {
+  GlyphSprite sprite(&tft);
+  sprite.loadFont((const uint8_t *)fonts[0].data());
+  sprite.unloadFont();
+  uint16_t index;
+  TEST_ASSERT_FALSE(sprite.glyphIndex('a', &index));
+  TEST_ASSERT_FALSE(sprite.glyphIndex(0x2019, &index));
+}
+
+// the library's drawGlyph, drawn into the same kind of sprite
+void test_names_draw_the_same_pixels() {
+  const int16_t width = 320;
+  const int16_t height = 40;
+  GlyphSprite sprite(&tft);
+  TFT_eSprite reference(&tft);
+  sprite.loadFont((const uint8_t *)fonts[0].data());
+  reference.loadFont((const uint8_t *)fonts[0].data());
+  TEST_ASSERT_NOT_NULL(sprite.createSprite(width, height));
+  TEST_ASSERT_NOT_NULL(reference.createSprite(width, height));
+
+  const uint16_t colors[][2] = {{TFT_WHITE, TFT_BLACK}, {0x3a4f, TFT_BLACK}, {TFT_LIGHTGREY, TFT_LIGHTGREY}};
+  for (auto &pair : colors) {
+    for (size_t i = 0; i < names.size(); i += 7) {
+      sprite.fillSprite(TFT_DARKGREY);
+      reference.fillSprite(TFT_DARKGREY);
+      sprite.setTextColor(pair[0], pair[1]);
+      reference.setTextColor(pair[0], pair[1]);
+      sprite.setCursor(2, 4);
+      reference.setCursor(2, 4);
+      sprite.printToSprite((char *)names[i].c_str(), names[i].size());
+      reference.printToSprite((char *)names[i].c_str(), names[i].size());
+      TEST_ASSERT_TRUE(sprite.cursor_x > 2);
+      TEST_ASSERT_EQUAL_INT32(reference.cursor_x, sprite.cursor_x);
+      TEST_ASSERT_EQUAL_MEMORY(reference.getPointer(), sprite.getPointer(), width * height * sizeof(uint16_t));
+    }
+  }
+}
+
+// more pairs than there are ramps, so some are replaced and built again along the way
+void test_blend_ramps_match_alpha_blend() {
+  RampSprite sprite(&tft);
+  const uint16_t colors[] = {TFT_WHITE, TFT_BLACK, TFT_LIGHTGREY, TFT_DARKGREY, TFT_RED, TFT_GREEN, TFT_BLUE, 0x3a4f};
+  for (int round = 0; round < 2; round++) {
+    for (uint16_t fg : colors) {
+      for (uint16_t bg : colors) {
+        const uint16_t *ramp = sprite.blendRamp(fg, bg);
+        for (uint16_t alpha = 0; alpha < 256; alpha++) {
+          TEST_ASSERT_EQUAL_HEX16(sprite.alphaBlend(alpha, fg, bg), ramp[alpha]);
+        }
+      }
+    }
+  }
+}
+
+// coloring the anti-aliased edge pixels of every name, blending each one against looking it up in the pair's ramp
+void test_benchmark_blending_edges() {
+  RampSprite sprite(&tft);
+  sprite.loadFont((const uint8_t *)fonts[0].data());
+  std::vector<uint8_t> edges;
+  for (auto &name : names) {
+    uint16_t n = 0;
+    while (n < name.size()) {
+      const uint16_t unicode = sprite.decodeUTF8((uint8_t *)name.data(), &n, name.size() - n);
+      uint16_t index;
+      if (!sprite.glyphIndex(unicode, &index)) continue;
+      const uint8_t *bitmap = sprite.gFont.gArray + sprite.gBitmap[index];
+      for (uint32_t i = 0; i < (uint32_t)sprite.gWidth[index] * sprite.gHeight[index]; i++) {
+        if (bitmap[i] != 0 && bitmap[i] != 0xff) edges.push_back(bitmap[i]);
+      }
+    }
+  }
+  const uint16_t colors[][2] = {{TFT_WHITE, TFT_BLACK}, {0x3a4f, TFT_BLACK}, {TFT_LIGHTGREY, TFT_DARKGREY}};
+  uint32_t blended = 0;
+  uint32_t looked = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (auto &pair : colors) {
+    for (uint8_t alpha : edges) blended += sprite.alphaBlend(alpha, pair[0], pair[1]);
+  }
+  const double blendMillis = elapsedMillis(start);
+
+  start = std::chrono::steady_clock::now();
+  for (auto &pair : colors) {
+    const uint16_t *ramp = sprite.blendRamp(pair[0], pair[1]);
+    for (uint8_t alpha : edges) looked += ramp[alpha];
+  }
+  const double rampMillis = elapsedMillis(start);
+
+  char message[128];
+  snprintf(message, sizeof(message), "%u edge pixels x %u color pairs: alphaBlend %.2f ms, blend ramp %.2f ms",
+           (unsigned)edges.size(), (unsigned)(sizeof(colors) / sizeof(colors[0])), blendMillis, rampMillis);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_EQUAL_UINT32(blended, looked);
+  TEST_ASSERT_TRUE(rampMillis < blendMillis);
+}
+
+void test_benchmark_measuring_names() {
+  GlyphSprite sprite(&tft);
+  sprite.loadFont((const uint8_t *)fonts[0].data());
+  uint32_t linearWidth = 0;
+  uint32_t tableWidth = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (auto &name : names) {
+    linearWidth += measure(sprite, name, [&](uint16_t u, uint16_t *index) { return sprite.getUnicodeIndex(u, index); });
+  }
+  const double linearMillis = elapsedMillis(start);
+
+  start = std::chrono::steady_clock::now();
+  for (auto &name : names) {
+    tableWidth += measure(sprite, name, [&](uint16_t u, uint16_t *index) { return sprite.glyphIndex(u, index); });
+  }
+  const double tableMillis = elapsedMillis(start);
+
+  char message[128];
+  snprintf(message, sizeof(message), "%u names, %u glyphs: getUnicodeIndex %.2f ms, glyphIndex %.2f ms",
+           (unsigned)names.size(), sprite.gFont.gCount, linearMillis, tableMillis);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_EQUAL_UINT32(linearWidth, tableWidth);
+  TEST_ASSERT_TRUE(tableMillis < linearMillis);
+}
+
+int main() {
+  fonts.push_back(readSourceFile("GillSans24.vlw"));
+  fonts.push_back(readSourceFile("icomoon24.vlw"));
+  fonts.push_back(readSourceFile("icomoon31.vlw"));
+  genreCatalog.setup();
+  char name[GENRE_NAME_SIZE];
+  for (uint16_t i = 0; i < genreCatalog.genreCount(); i++) {
+    names.push_back(genreCatalog.genreName(i, name, sizeof(name)));
+  }
+
+  for (auto &font : fonts) {
+    if (font.empty()) {
+      printf("fonts not found in src\n");
+      return 1;
+    }
+  }
+
+  UNITY_BEGIN();
+  RUN_TEST(test_glyph_index_matches_get_unicode_index);
+  RUN_TEST(test_unloading_clears_the_tables);
+  RUN_TEST(test_names_draw_the_same_pixels);
+  RUN_TEST(test_blend_ramps_match_alpha_blend);
+  RUN_TEST(test_benchmark_measuring_names);
+  RUN_TEST(test_benchmark_blending_edges);
+  return UNITY_END();
+}
@@ -0,0 +1,198 @@
+#include <unity.h>
+
+#include <string>
+#include <vector>
+
+#include "JpegStream.cpp"
+
+// A stand-in for tjpgd that reads the way it does: a header, a segment it skips, then the rest of the file in
+// refills of its input buffer, checking every byte. It then puts out a 72x72 image in 16x16 blocks, with each pixel
+// holding its own row and column.
+static const size_t headerBytes = 100;
+static const size_t skippedBytes = 300;
+static const uint16_t imageSize = 72;
+static size_t fileLength = 0;
+
+static uint8_t fileByte(size_t i) { return (uint8_t)(i * 7 + 3); }
+
+JRESULT jd_prepare(JDEC *jd, size_t (*infunc)(JDEC *, uint8_t *, size_t), void *pool, size_t sz_pool, void *dev) {
+  jd->infunc = infunc;
+  jd->device = dev;
+  jd->pool = pool;
+  jd->sz_pool = sz_pool;
+  uint8_t header[headerBytes];
+  if (infunc(jd, header, headerBytes) != headerBytes) return JDR_INP;
+  for (size_t i = 0; i < headerBytes; i++) {
+    if (header[i] != fileByte(i)) return JDR_FMT1;
+  }
+  if (infunc(jd, nullptr, skippedBytes) != skippedBytes) return JDR_INP;
+  return JDR_OK;
+}
+
+JRESULT jd_decomp(JDEC *jd, int (*outfunc)(JDEC *, void *, JRECT *), uint8_t scale) {
+  // like tjpgd, asks for a whole buffer at a time and takes a short read at the end of the file
+  uint8_t buffer[512];
+  for (size_t offset = headerBytes + skippedBytes; offset < fileLength;) {
+    const size_t read = std::min(jd->infunc(jd, buffer, sizeof(buffer)), fileLength - offset);
+    if (read == 0) return JDR_INP;
+    for (size_t i = 0; i < read; i++) {
+      if (buffer[i] != fileByte(offset + i)) return JDR_FMT1;
+    }
+    offset += read;
+  }
+  uint16_t pixels[16 * 16];
+  for (uint16_t top = 0; top < imageSize; top += 16) {
+    for (uint16_t left = 0; left < imageSize; left += 16) {
+      for (int i = 0; i < 16 * 16; i++) {
+        const uint16_t color = (top + i / 16) << 8 | (left + i % 16);
+        pixels[i] = jd->swap ? (color >> 8) | (color << 8) : color;
+      }
+      JRECT rect = {left, (uint16_t)(left + 15), top, (uint16_t)(top + 15)};
+      if (!outfunc(jd, pixels, &rect)) return JDR_INTR;
+    }
+  }
+  return JDR_OK;
+}
+
+// a connection that hands out at most packet bytes at a time, and after stopAt bytes either closes or goes quiet
+class FakeClient : public Client {
+ public:
+  FakeClient(const std::string &data, size_t packet, bool closes = true, size_t stopAt = SIZE_MAX)
+      : data(data), packet(packet), closes(closes), stopAt(std::min(stopAt, data.size())) {}
+
+  int available() override { return std::min(packet, stopAt - position); }
+  int read() override { return position < stopAt ? (uint8_t)data[position++] : -1; }
+  int read(uint8_t *buffer, size_t size) override {
+    size = std::min(size, stopAt - position);
+    memcpy(buffer, data.data() + position, size);
+    position += size;
+    return size;
+  }
+  size_t write(uint8_t byte) override { return 0; }
+  uint8_t connected() override { return !closes || position < stopAt; }
+
+  std::string data;
+  size_t packet;
+  bool closes;
+  size_t stopAt;
+  size_t position = 0;
+};
+
+static std::string file(size_t length) {
+  fileLength = length;
+  std::string data;
+  for (size_t i = 0; i < length; i++) data += (char)fileByte(i);
+  return data;
+}
+
+// cut into chunks of the given sizes in turn, some with extensions, the way a chunked response arrives
+static std::string chunked(const std::string &body, std::vector<size_t> sizes) {
+  std::string data;
+  char line[32];
+  size_t offset = 0;
+  for (size_t i = 0; offset < body.size(); i++) {
+    const size_t size = std::min(sizes[i % sizes.size()], body.size() - offset);
+    snprintf(line, sizeof(line), i % 3 == 2 ? "%zx;name=value\r\n" : "%zX\r\n", size);
+    data += line + body.substr(offset, size) + "\r\n";
+    offset += size;
+  }
+  return data + "0\r\n\r\n";
+}
+
+static uint16_t tile[64 * 64];
+
+static JRESULT decode(Client &client, int length, bool isChunked) {
+  memset(tile, 0, sizeof(tile));
+  return jpegStream.decode(&client, length, isChunked, tile, 64, 64);
+}
+
+// clipped to the tile and byte swapped for the display
+static void assertTile() {
+  for (uint16_t y = 0; y < 64; y++) {
+    for (uint16_t x = 0; x < 64; x++) TEST_ASSERT_EQUAL_HEX16(x << 8 | y, tile[y * 64 + x]);
+  }
+}
+
+void setUp() {
+  fakeMicros() = 0;
+  fakeErrorLogs() = 0;
+}
+void tearDown() {}
+
+void test_bodies_with_a_length_arrive_intact() {
+  const std::string body = file(6000);
+  for (size_t packet : {1, 7, 536, 1460, 100000}) {
+    FakeClient client(body, packet);
+    TEST_ASSERT_EQUAL(JDR_OK, decode(client, body.size(), false));
+    TEST_ASSERT_EQUAL_UINT32(body.size(), jpegStream.bytesRead());
+    assertTile();
+  }
+}
+
+void test_chunked_bodies_arrive_intact() {
+  const std::string body = file(6000);
+  const std::vector<std::vector<size_t>> chunkSizes = {{1}, {100, 3, 1460}, {512}, {4096}, {6000}};
+  for (auto &sizes : chunkSizes) {
+    for (size_t packet : {1, 5, 1460}) {
+      FakeClient client(chunked(body, sizes), packet);
+      TEST_ASSERT_EQUAL(JDR_OK, decode(client, -1, true));
+      TEST_ASSERT_EQUAL_UINT32(body.size(), jpegStream.bytesRead());
+      assertTile();
+    }
+  }
+}
+
+void test_bodies_without_a_length_end_with_the_connection() {
+  const std::string body = file(6000);
+  for (size_t packet : {1, 1460, 100000}) {
+    FakeClient client(body, packet);
+    TEST_ASSERT_EQUAL(JDR_OK, decode(client, -1, false));
+    assertTile();
+  }
+  // closing is how the body ends, not an error
+  TEST_ASSERT_EQUAL_UINT32(0, fakeErrorLogs());
+}
+
+// a response that closes early fails without waiting, however the body is sent
+void test_short_responses_fail_at_once() {
+  const std::string body = file(6000);
+  for (size_t stopAt : {50, 3000}) {
+    FakeClient client(body, 1460, true, stopAt);
+    TEST_ASSERT_EQUAL(JDR_INP, decode(client, body.size(), false));
+    FakeClient chunkedClient(chunked(body, {1000}), 1460, true, stopAt);
+    TEST_ASSERT_EQUAL(JDR_INP, decode(chunkedClient, -1, true));
+  }
+  TEST_ASSERT_EQUAL_UINT32(4, fakeErrorLogs());
+  TEST_ASSERT_TRUE(millis() < 100);
+}
+
+// the stall is only waited out once, not again for each read the decoder makes after it
+void test_stalls_fail_once() {
+  const std::string body = file(6000);
+  FakeClient client(body, 1460, false, 3000);
+  TEST_ASSERT_EQUAL(JDR_INP, decode(client, body.size(), false));
+  TEST_ASSERT_EQUAL_UINT32(3000, jpegStream.bytesRead());
+  TEST_ASSERT_TRUE(millis() > JPEG_STREAM_STALL_MILLIS);
+  TEST_ASSERT_TRUE(millis() < JPEG_STREAM_STALL_MILLIS * 2);
+}
+
+void test_invalid_chunk_sizes_fail() {
+  const std::string body = file(6000);
+  std::string data = chunked(body, {1000});
+  data.replace(data.find("\r\n3E8") + 2, 3, "zzz");
+  FakeClient client(data, 1460, false);
+  TEST_ASSERT_EQUAL(JDR_INP, decode(client, -1, true));
+  TEST_ASSERT_EQUAL_UINT32(1000, jpegStream.bytesRead());
+  TEST_ASSERT_TRUE(millis() < 100);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_bodies_with_a_length_arrive_intact);
+  RUN_TEST(test_chunked_bodies_arrive_intact);
+  RUN_TEST(test_bodies_without_a_length_end_with_the_connection);
+  RUN_TEST(test_short_responses_fail_at_once);
+  RUN_TEST(test_stalls_fail_once);
+  RUN_TEST(test_invalid_chunk_sizes_fail);
+  return UNITY_END();
+}
@@ -0,0 +1,145 @@
+#include <unity.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "GenreCatalog.cpp"
+
+static GenreCatalog catalog;
+// every genre and country playlist in base62, the way they were stored and scanned before the hash
+static std::vector<std::string> ids;
+
+static double elapsedNanos(std::chrono::steady_clock::time_point start, size_t count) {
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / count;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_every_playlist_finds_its_entity() {
+  for (uint16_t i = 0; i < catalog.genreCount(); i++) {
+    TEST_ASSERT_EQUAL_INT(i, catalog.findPlaylist(catalog.genrePlaylist(i)));
+  }
+  for (uint16_t i = 0; i < catalog.countryCount(); i++) {
+    TEST_ASSERT_EQUAL_INT(catalog.genreCount() + i, catalog.findPlaylist(catalog.countryPlaylist(i)));
+  }
+}
+
+void test_other_ids_are_not_found() {
+  srand(1);
+  for (int i = 0; i < 100000; i++) {
+    const SpotifyId id(((uint64_t)rand() << 32) ^ rand(), ((uint64_t)rand() << 32) ^ rand());
+    TEST_ASSERT_EQUAL_INT(-1, catalog.findPlaylist(id));
+  }
+  TEST_ASSERT_EQUAL_INT(-1, catalog.findPlaylist(SpotifyId()));
+}
+
+void test_base62_round_trip() {
+  char encoded[SPOTIFY_ID_SIZE + 1];
+  for (auto &id : ids) {
+    SpotifyId::decode(id.c_str()).encode(encoded);
+    TEST_ASSERT_EQUAL_STRING(id.c_str(), encoded);
+  }
+}
+
+void test_genre_names_fit() {
+  char name[GENRE_NAME_SIZE + 1];
+  for (uint16_t i = 0; i < catalog.genreCount(); i++) {
+    TEST_ASSERT_TRUE(strlen(catalog.genreName(i, name, sizeof(name))) < GENRE_NAME_SIZE);
+  }
+}
+
+// copies outlive the cache block they came from, and short buffers are cut off rather than overrun
+void test_genre_names_are_copied() {
+  char first[GENRE_NAME_SIZE];
+  char again[GENRE_NAME_SIZE];
+  catalog.genreName(0, first, sizeof(first));
+  for (uint16_t i = 0; i < catalog.genreCount(); i += GENRE_NAME_CACHE_BLOCK_NAMES) {
+    catalog.genreName(i, again, sizeof(again));
+  }
+  TEST_ASSERT_EQUAL_STRING(first, catalog.genreName(0, again, sizeof(again)));
+
+  char cut[3] = {'x', 'x', 'x'};
+  catalog.genreName(0, cut, sizeof(cut));
+  TEST_ASSERT_EQUAL_INT(0, strncmp(first, cut, 2));
+  TEST_ASSERT_EQUAL_INT('\0', cut[2]);
+}
+
+// the linear strcmp scan the hash replaced, against decoding the id and looking it up
+void test_benchmark_against_scan() {
+  volatile uint32_t found = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (auto &id : ids) {
+    for (size_t i = 0; i < ids.size(); i++) {
+      if (strcmp(ids[i].c_str(), id.c_str()) == 0) {
+        found = found + i;
+        break;
+      }
+    }
+  }
+  const double scanNanos = elapsedNanos(start, ids.size());
+
+  const int rounds = 100;
+  start = std::chrono::steady_clock::now();
+  for (int round = 0; round < rounds; round++) {
+    for (auto &id : ids) found = found + catalog.findPlaylist(SpotifyId::decode(id.c_str()));
+  }
+  const double hashNanos = elapsedNanos(start, ids.size() * rounds);
+
+  char message[128];
+  snprintf(message, sizeof(message), "%u ids: scan %.0f ns, decode and hash %.0f ns per lookup", (unsigned)ids.size(),
+           scanNanos, hashNanos);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_TRUE(hashNanos < scanNanos);
+}
+
+// front coded names decode a whole block on a cache miss, so random access pays for up to a block of names per call
+void test_benchmark_genre_names() {
+  char name[GENRE_NAME_SIZE];
+  volatile uint32_t length = 0;
+  const int rounds = 20;
+  auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < rounds; round++) {
+    for (uint16_t i = 0; i < catalog.genreCount(); i++) {
+      length = length + strlen(catalog.genreName(i, name, sizeof(name)));
+    }
+  }
+  const double sequentialNanos = elapsedNanos(start, catalog.genreCount() * rounds);
+
+  std::vector<uint16_t> indexes;
+  srand(1);
+  for (int i = 0; i < catalog.genreCount() * rounds; i++) indexes.push_back(rand() % catalog.genreCount());
+  start = std::chrono::steady_clock::now();
+  for (auto index : indexes) length = length + strlen(catalog.genreName(index, name, sizeof(name)));
+  const double randomNanos = elapsedNanos(start, indexes.size());
+
+  char message[128];
+  snprintf(message, sizeof(message), "%u genres: sequential %.0f ns, random %.0f ns per name",
+           (unsigned)catalog.genreCount(), sequentialNanos, randomNanos);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_TRUE(randomNanos < 5000);
+}
+
+int main() {
+  catalog.setup();
+  char encoded[SPOTIFY_ID_SIZE + 1];
+  for (uint16_t i = 0; i < catalog.genreCount(); i++) {
+    catalog.genrePlaylist(i).encode(encoded);
+    ids.push_back(encoded);
+  }
+  for (uint16_t i = 0; i < catalog.countryCount(); i++) {
+    catalog.countryPlaylist(i).encode(encoded);
+    ids.push_back(encoded);
+  }
+
+  UNITY_BEGIN();
+  RUN_TEST(test_every_playlist_finds_its_entity);
+  RUN_TEST(test_other_ids_are_not_found);
+  RUN_TEST(test_base62_round_trip);
+  RUN_TEST(test_genre_names_fit);
+  RUN_TEST(test_genre_names_are_copied);
+  RUN_TEST(test_benchmark_against_scan);
+  RUN_TEST(test_benchmark_genre_names);
+  return UNITY_END();
+}
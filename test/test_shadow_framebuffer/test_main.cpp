@@ -0,0 +1,165 @@
+#include <unity.h>
+
+#include <string>
+#include <vector>
+
+#include "GenreCatalog.cpp"
+#include "GlyphSprite.cpp"
+#include "ShadowFramebuffer.cpp"
+#include "source_files.h"
+
+static const int32_t screenWidth = 240;
+static const int32_t screenHeight = 135;
+static TFT_eSPI tft(screenWidth, screenHeight);
+static std::string font;
+
+typedef struct {
+  int32_t x;
+  int32_t y;
+  int32_t w;
+  int32_t h;
+} Region_t;
+
+// a display that keeps what it was sent and the regions it came in
+class RecordingDisplay : public FramebufferDisplay {
+ public:
+  RecordingDisplay(uint16_t *pixels) : FramebufferDisplay(pixels, screenWidth, screenHeight) {}
+
+  void pushRegion(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *pixels, int32_t stride) override {
+    FramebufferDisplay::pushRegion(x, y, w, h, pixels, stride);
+    pushed.push_back({x, y, w, h});
+  }
+
+  std::vector<Region_t> pushed;
+};
+
+// one frame of the genre list, the way drawCenteredText and the seek bar compose it
+static void drawFrame(ShadowFramebuffer &shadow, GlyphSprite &line, const char *name, uint32_t color, int32_t seek) {
+  line.fillSprite(TFT_BLACK);
+  line.setTextColor(color, TFT_BLACK);
+  line.setCursor(4, 2);
+  line.printToSprite((char *)name, strlen(name));
+  shadow.pushRegion(10, 40, line.width(), line.height(), (uint16_t *)line.getPointer(), line.width());
+  shadow.fillRegion(0, 0, screenWidth, 3, TFT_BLACK);
+  shadow.fillRegion(20, 110, seek, 4, TFT_WHITE);
+  shadow.fillRegion(20 + seek, 110, 200 - seek, 4, TFT_DARKGREY);
+  shadow.drawPixel(seek % screenWidth, 2, TFT_RED);
+}
+
+// every pixel that changed went out, and every region starts and ends on a changed pixel in each of its rows
+static void assertSpansMatch(const uint16_t *before, const uint16_t *after, const std::vector<Region_t> &pushed) {
+  std::vector<uint8_t> covered(screenWidth * screenHeight, 0);
+  for (auto &region : pushed) {
+    TEST_ASSERT_TRUE(region.w > 0 && region.h > 0);
+    for (int32_t row = region.y; row < region.y + region.h; row++) {
+      const int32_t first = row * screenWidth + region.x;
+      const int32_t last = first + region.w - 1;
+      TEST_ASSERT_TRUE(before[first] != after[first]);
+      TEST_ASSERT_TRUE(before[last] != after[last]);
+      for (int32_t i = first; i <= last; i++) {
+        TEST_ASSERT_EQUAL_UINT8(0, covered[i]);
+        covered[i] = 1;
+      }
+    }
+  }
+  for (int32_t i = 0; i < screenWidth * screenHeight; i++) {
+    if (before[i] != after[i]) TEST_ASSERT_EQUAL_UINT8(1, covered[i]);
+  }
+}
+
+static std::vector<uint16_t> frame(screenWidth *screenHeight);
+static std::vector<uint16_t> sent(screenWidth *screenHeight);
+static std::vector<uint16_t> screen(screenWidth *screenHeight);
+
+void setUp() {}
+void tearDown() {}
+
+void test_the_first_flush_sends_everything() {
+  ShadowFramebuffer shadow;
+  RecordingDisplay display(screen.data());
+  shadow.begin(frame.data(), sent.data(), screenWidth, screenHeight);
+  TEST_ASSERT_EQUAL_UINT32(screenWidth * screenHeight, shadow.flush(display));
+  TEST_ASSERT_EQUAL_UINT32(1, display.pushed.size());
+  TEST_ASSERT_EQUAL_UINT32(0, shadow.flush(display));
+}
+
+void test_recorded_frames_push_what_changed() {
+  ShadowFramebuffer shadow;
+  RecordingDisplay display(screen.data());
+  GlyphSprite line(&tft);
+  line.loadFont((const uint8_t *)font.data());
+  TEST_ASSERT_NOT_NULL(line.createSprite(220, line.gFont.yAdvance + 4));
+  shadow.begin(frame.data(), sent.data(), screenWidth, screenHeight);
+  shadow.flush(display);
+
+  // spinning through the genre list, with the seek bar moving along
+  char name[GENRE_NAME_SIZE];
+  uint32_t frames = 0;
+  std::vector<uint16_t> before;
+  for (uint16_t i = 0; i < genreCatalog.genreCount(); i += 37) {
+    before = screen;
+    display.pushed.clear();
+    drawFrame(shadow, line, genreCatalog.genreName(i, name, sizeof(name)), genreCatalog.genreColor(i), i % 200);
+    const uint32_t pushed = shadow.flush(display);
+    assertSpansMatch(before.data(), shadow.frame(), display.pushed);
+    TEST_ASSERT_EQUAL_MEMORY(shadow.frame(), screen.data(), screen.size() * sizeof(uint16_t));
+    uint32_t regionPixels = 0;
+    for (auto &region : display.pushed) regionPixels += region.w * region.h;
+    TEST_ASSERT_EQUAL_UINT32(regionPixels, pushed);
+    frames++;
+  }
+
+  // the same frame again has nothing to push
+  drawFrame(shadow, line, genreCatalog.genreName(0, name, sizeof(name)), genreCatalog.genreColor(0), 0);
+  shadow.flush(display);
+  display.pushed.clear();
+  drawFrame(shadow, line, genreCatalog.genreName(0, name, sizeof(name)), genreCatalog.genreColor(0), 0);
+  TEST_ASSERT_EQUAL_UINT32(0, shadow.flush(display));
+  TEST_ASSERT_EQUAL_UINT32(0, display.pushed.size());
+
+  char message[128];
+  snprintf(message, sizeof(message), "%u frames: %u pixels pushed, %u unchanged", frames, shadow.pixelsPushed(),
+           shadow.pixelsSkipped());
+  TEST_MESSAGE(message);
+}
+
+// changes further apart than the merge gap are separate spans, closer ones are pushed as one
+void test_nearby_changes_are_joined() {
+  uint16_t before[64] = {};
+  uint16_t after[64] = {};
+  after[3] = after[3 + SHADOW_FRAMEBUFFER_MERGE_GAP] = 1;
+  after[40] = 1;
+  ShadowFramebufferSpan_t spans[SHADOW_FRAMEBUFFER_MAX_ROW_SPANS];
+  TEST_ASSERT_EQUAL_UINT8(2, ShadowFramebuffer::diffRow(after, before, 64, spans, SHADOW_FRAMEBUFFER_MAX_ROW_SPANS));
+  TEST_ASSERT_EQUAL_INT32(3, spans[0].x);
+  TEST_ASSERT_EQUAL_INT32(SHADOW_FRAMEBUFFER_MERGE_GAP + 1, spans[0].w);
+  TEST_ASSERT_EQUAL_INT32(40, spans[1].x);
+  TEST_ASSERT_EQUAL_INT32(1, spans[1].w);
+}
+
+// past the span limit, the last span takes in the rest of the row's changes
+void test_spans_past_the_limit_are_joined() {
+  uint16_t before[256] = {};
+  uint16_t after[256] = {};
+  for (int i = 0; i < 20; i++) after[i * 12] = 1;
+  ShadowFramebufferSpan_t spans[SHADOW_FRAMEBUFFER_MAX_ROW_SPANS];
+  const uint8_t count = ShadowFramebuffer::diffRow(after, before, 256, spans, SHADOW_FRAMEBUFFER_MAX_ROW_SPANS);
+  TEST_ASSERT_EQUAL_UINT8(SHADOW_FRAMEBUFFER_MAX_ROW_SPANS, count);
+  TEST_ASSERT_EQUAL_INT32(19 * 12 + 1, spans[count - 1].x + spans[count - 1].w);
+}
+
+int main() {
+  font = readSourceFile("GillSans24.vlw");
+  if (font.empty()) {
+    printf("fonts not found in src\n");
+    return 1;
+  }
+  genreCatalog.setup();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_the_first_flush_sends_everything);
+  RUN_TEST(test_recorded_frames_push_what_changed);
+  RUN_TEST(test_nearby_changes_are_joined);
+  RUN_TEST(test_spans_past_the_limit_are_joined);
+  return UNITY_END();
+}